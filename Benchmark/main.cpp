@@ -0,0 +1,203 @@
+// Copyright (C) 2011-2014 by Maximilian Hnig
+// This file is part of "DunGen - the Dungeongenerator".
+// For conditions of distribution and use, see licence.txt provided together with DunGen.
+
+#include <iostream>
+#include <string>
+#include <irrlicht.h>
+#include <DunGen.h>
+
+#ifdef _MSC_VER
+#pragma comment(lib, "Irrlicht.lib")
+#endif
+
+// The DunGen sources are compiled into this program, so the voxel layout is chosen by the configuration:
+// "Release" stores the voxels linear, "Release Morton" defines DUNGEN_VOXEL_LAYOUT_MORTON.
+
+/// minimum and sum of the times of a generation step
+struct SStepTime
+{
+	SStepTime() : Min(0xffffffff), Sum(0) {}
+
+	void Add(irr::u32 time_)
+	{
+		if (time_ < Min)
+			Min = time_;
+		Sum += time_;
+	}
+
+	irr::u32 Min;
+	irr::u32 Sum;
+};
+
+/// expected result of the deterministic check
+struct SCheckResult
+{
+	const char* Name;						///< name of the check
+	bool LegacyMode;						///< legacy mode of the random generator
+	DunGen::EFilterMode::Enum FilterMode;	///< filter mode
+	irr::u32 Checksum;						///< checksum of all voxels after filtering
+	unsigned int Triangles;					///< estimated mesh complexity after filtering
+};
+
+/// the cave of Tutorial 01 in the default voxel space, eroded once and filtered:
+/// the legacy results were computed with the sources of version 1.2.4 (voxel space stored as one array, outer hull filter),
+/// version 2.0 reproduces them for this cave (other caves can differ, since their tunnels are rasterized as capsules now)
+/// the hash results were computed with version 2.0
+static const SCheckResult CheckResults[2] =
+{
+	{"legacy", true, DunGen::EFilterMode::OUTER_HULL, 0x215f1de0, 825044},
+	{"hash", false, DunGen::EFilterMode::COMPONENTS, 0x2e765b56, 825640}
+};
+
+/// creates the voxel cave of the current L-system derivation with fixed settings and compares it to the expected results,
+/// returns true, if all results are as expected
+static bool CheckVoxelCave(DunGen::CDunGen* dunGen_)
+{
+	dunGen_->VoxelCaveSetDimensions(DunGen::SVoxelSpace::DefaultDimX, DunGen::SVoxelSpace::DefaultDimY, DunGen::SVoxelSpace::DefaultDimZ);
+	const irr::core::vector3d<unsigned int> dimensions = dunGen_->VoxelCaveGetDimensions();
+
+	bool passed = true;
+	for (unsigned int i=0; i<2; ++i)
+	{
+		const SCheckResult& expected = CheckResults[i];
+		dunGen_->RandomGeneratorSetParameters(0, 1103515245, 12345, 32768);
+		dunGen_->RandomGeneratorSetLegacyMode(expected.LegacyMode);
+		dunGen_->VoxelCaveSetFilterMode(expected.FilterMode);
+		dunGen_->CreateVoxelCave();
+		dunGen_->ErodeVoxelCave(0.5);
+		dunGen_->RemoveHoveringVoxelFragments();
+
+		// FNV-1a hash of all voxels
+		irr::u32 checksum = 2166136261u;
+		for (unsigned int x=0; x<dimensions.X; ++x)
+			for (unsigned int y=0; y<dimensions.Y; ++y)
+				for (unsigned int z=0; z<dimensions.Z; ++z)
+				{
+					checksum ^= dunGen_->VoxelCaveGetVoxel(x,y,z);
+					checksum *= 16777619u;
+				}
+		const unsigned int triangles = dunGen_->VoxelCaveEstimateMeshComplexity();
+
+		const bool ok = (checksum == expected.Checksum) && (triangles == expected.Triangles);
+		std::cout << "check " << expected.Name << ": checksum " << std::hex << checksum << std::dec << " , estimated triangles " << triangles
+			<< (ok ? " , ok" : " , FAILED") << std::endl;
+		if (!ok)
+		{
+			std::cout << "  expected: checksum " << std::hex << expected.Checksum << std::dec << " , estimated triangles " << expected.Triangles << std::endl;
+			passed = false;
+		}
+	}
+
+	return passed;
+}
+
+int main(int argc, char* argv[])
+{
+	// "check" as first parameter: compare a fixed cave to the expected results instead of timing
+	const bool check = (argc>=2) && (std::string("check") == argv[1]);
+
+	// check for additional parameters: number of runs, dimension of the voxel space
+	unsigned int runs = 3;
+	if (argc>=2 && !check)
+		runs = atoi(argv[1]);
+	unsigned int dim = DunGen::SVoxelSpace::DefaultDimX;
+	if (argc>=3 && !check)
+		dim = atoi(argv[2]);
+	if (runs < 1)
+		runs = 1;
+
+	std::cout << "Dungeongenerator Benchmark is started." << std::endl;
+#ifdef DUNGEN_VOXEL_LAYOUT_MORTON
+	std::cout << "Voxel layout: Morton" << std::endl;
+#else
+	std::cout << "Voxel layout: linear" << std::endl;
+#endif
+
+	// create Irrlicht device, no window is needed
+	irr::IrrlichtDevice* irrDevice = irr::createDevice(irr::video::EDT_NULL);
+	if(irrDevice == 0)
+	{
+		std::cout << "Irrlicht device could not be created, program is terminated." << std::endl;
+		return 1;
+	}
+	irr::ITimer* timer = irrDevice->getTimer();
+
+	// create Dungeongenerator instance
+	DunGen::CDunGen *dunGen = new DunGen::CDunGen(irrDevice);
+	dunGen->StartUp();
+	dunGen->SetPrintToConsole(false);
+
+	// create L-system (the cave of Tutorial 01)
+	dunGen->LSystemSetStart("YYFYF");
+	dunGen->LSystemAddRule('F',"F-YX-X---");
+	dunGen->LSystemAddRule('X',"F$F++F-X");
+	dunGen->LSystemAddRule('Y',"oYX--XX++");
+	dunGen->LSystemSetParameter(DunGen::ELSystemParameter::ANGLE_YAW, 250.0);
+	dunGen->LSystemSetParameter(DunGen::ELSystemParameter::ANGLE_PITCH, 1.0);
+	dunGen->LSystemSetParameter(DunGen::ELSystemParameter::ANGLE_ROLL, 0.0);
+	dunGen->LSystemSetParameter(DunGen::ELSystemParameter::RADIUS_DECREMENT, 0.0);
+	dunGen->LSystemSetParameter(DunGen::ELSystemParameter::RADIUS_FACTOR, 1.0);
+	dunGen->LSystemSetParameter(DunGen::ELSystemParameter::RADIUS_START, 14.0);
+	dunGen->CreateLSystemDerivation(8);
+
+	// deterministic check of legacy and hash mode
+	if (check)
+	{
+		const bool passed = CheckVoxelCave(dunGen);
+		std::cout << (passed ? "All checks passed." : "Check FAILED.") << std::endl;
+
+		dunGen->ShutDown();
+		delete dunGen;
+		irrDevice->drop();
+		return passed ? 0 : 1;
+	}
+
+	dunGen->VoxelCaveSetDimensions(dim, dim, dim);
+	const irr::core::vector3d<unsigned int> dimensions = dunGen->VoxelCaveGetDimensions();
+	std::cout << "Voxel space: " << dimensions.X << " * " << dimensions.Y << " * " << dimensions.Z << " , runs: " << runs << std::endl;
+
+	// time the generation steps, the voxel cave is created again in every run
+	SStepTime drawTime, erodeTime, filterTime, estimateTime, meshTime;
+	unsigned int triangles = 0;
+	for (unsigned int run=0; run<runs; ++run)
+	{
+		irr::u32 start = timer->getRealTime();
+		dunGen->CreateVoxelCave();
+		drawTime.Add(timer->getRealTime()-start);
+
+		start = timer->getRealTime();
+		dunGen->ErodeVoxelCave(0.5);
+		erodeTime.Add(timer->getRealTime()-start);
+
+		start = timer->getRealTime();
+		dunGen->RemoveHoveringVoxelFragments();
+		filterTime.Add(timer->getRealTime()-start);
+
+		start = timer->getRealTime();
+		triangles = dunGen->VoxelCaveEstimateMeshComplexity();
+		estimateTime.Add(timer->getRealTime()-start);
+
+		start = timer->getRealTime();
+		dunGen->CreateMeshCave();
+		meshTime.Add(timer->getRealTime()-start);
+
+		std::cout << "run " << run+1 << " of " << runs << " done." << std::endl;
+	}
+
+	// report: minimum and average in milliseconds
+	std::cout << "estimated triangles: " << triangles << std::endl;
+	std::cout << "step            min [ms]  average [ms]" << std::endl;
+	std::cout << "draw            " << drawTime.Min << "  " << drawTime.Sum/runs << std::endl;
+	std::cout << "erode           " << erodeTime.Min << "  " << erodeTime.Sum/runs << std::endl;
+	std::cout << "filter          " << filterTime.Min << "  " << filterTime.Sum/runs << std::endl;
+	std::cout << "estimate        " << estimateTime.Min << "  " << estimateTime.Sum/runs << std::endl;
+	std::cout << "mesh            " << meshTime.Min << "  " << meshTime.Sum/runs << std::endl;
+
+	// clean up
+	dunGen->ShutDown();
+	delete dunGen;
+	irrDevice->drop();
+
+	return 0;
+}
@@ -37,7 +37,7 @@ bool DunGen::CArchitect::CreateDockingSite(SDockingSite &dockingSite_,
 
 			const unsigned int startX = (EDirection::X_POSITIVE == direction_) ? minVox_.X : maxVox_.X;
 			const unsigned int endX = (EDirection::X_POSITIVE == direction_) ?
-				SVoxelSpace::DimX-SVoxelSpace::MinBorder : VoxelCave->MinBorderFilter; // 3 stone voxel at border
+				VoxelCave->GetDimX()-SVoxelSpace::MinBorder : VoxelCave->MinBorderFilter; // 3 stone voxel at border
 			const int increment = (EDirection::X_POSITIVE == direction_) ? 1 : -1;
 			const int depthModificator = maxVox_.X - minVox_.X + 1;
 
@@ -61,8 +61,8 @@ bool DunGen::CArchitect::CreateDockingSite(SDockingSite &dockingSite_,
 			// docking position has to be at least 2 voxel from border, so that digging starts 3 voxel away from border
 			if (begin < static_cast<int>(VoxelCave->MinBorderFilter))
 				begin = VoxelCave->MinBorderFilter;
-			else if (begin > static_cast<int>(SVoxelSpace::DimX-SVoxelSpace::MinBorder))
-				begin = SVoxelSpace::DimX-SVoxelSpace::MinBorder;
+			else if (begin > static_cast<int>(VoxelCave->GetDimX()-SVoxelSpace::MinBorder))
+				begin = VoxelCave->GetDimX()-SVoxelSpace::MinBorder;
 
 			// dig away the stone voxels & mark docking site
 			for (unsigned int x=begin+increment; x!=endX; x+=increment)
@@ -130,7 +130,7 @@ bool DunGen::CArchitect::CreateDockingSite(SDockingSite &dockingSite_,
 
 			const unsigned int startZ = (EDirection::Z_POSITIVE == direction_) ? minVox_.Z : maxVox_.Z;
 			const unsigned int endZ = (EDirection::Z_POSITIVE == direction_) ?
-				SVoxelSpace::DimZ-SVoxelSpace::MinBorder : VoxelCave->MinBorderFilter; // 3 stone voxel at border
+				VoxelCave->GetDimZ()-SVoxelSpace::MinBorder : VoxelCave->MinBorderFilter; // 3 stone voxel at border
 			const int increment = (EDirection::Z_POSITIVE == direction_) ? 1 : -1;
 			const int depthModificator = maxVox_.Z - minVox_.Z + 1;
 
@@ -154,8 +154,8 @@ bool DunGen::CArchitect::CreateDockingSite(SDockingSite &dockingSite_,
 			// docking position has to be at least 2 voxel from border, so that digging starts 3 voxel away from border
 			if (begin < static_cast<int>(VoxelCave->MinBorderFilter))
 				begin = VoxelCave->MinBorderFilter;
-			else if (begin > static_cast<int>(SVoxelSpace::DimZ-SVoxelSpace::MinBorder))
-				begin = SVoxelSpace::DimZ-SVoxelSpace::MinBorder;
+			else if (begin > static_cast<int>(VoxelCave->GetDimZ()-SVoxelSpace::MinBorder))
+				begin = VoxelCave->GetDimZ()-SVoxelSpace::MinBorder;
 
 			// dig away the stone voxels & mark docking site
 			for (unsigned int z=begin+increment; z!=endZ; z+=increment)
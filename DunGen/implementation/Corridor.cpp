@@ -284,7 +284,8 @@ double DunGen::CCorridor::CreateCorridor(const SCorridorProfile& profile_,
 // detail objects
 // ======================================================
 
-void DunGen::CCorridor::PlaceDetailObject(const SDetailobjectParameters& parameters_, const CRandomGenerator* randomGenerator_)
+void DunGen::CCorridor::PlaceDetailObject(const SDetailobjectParameters& parameters_, const CRandomGenerator* randomGenerator_,
+	unsigned int corridorIndex_, unsigned int parameterIndex_)
 {
 	// create new detail object
 	SDetailObject* newDetailObject = new SDetailObject();
@@ -302,9 +303,15 @@ void DunGen::CCorridor::PlaceDetailObject(const SDetailobjectParameters& paramet
 	// place objects along the spline
 	//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~	
 
+	// hash generator: the random numbers depend on corridor, detail object parameters and number of placed objects
+	const bool legacyMode = randomGenerator_->IsLegacyMode();
+	const unsigned int seed = randomGenerator_->GetHashSeed();
+
 	// multiple of the _DistanceSampling
-	unsigned int distanceFactor = parameters_.DistanceNumFactor*
-		randomGenerator_->GetRandomNumberMinMax(parameters_.DistanceNumMinFirstElement,parameters_.DistanceNumMaxFirstElement);
+	unsigned int distanceFactor = parameters_.DistanceNumFactor*(legacyMode
+		? randomGenerator_->GetRandomNumberMinMax(parameters_.DistanceNumMinFirstElement,parameters_.DistanceNumMaxFirstElement)
+		: randomGenerator_->GetHashNumberMinMax(parameters_.DistanceNumMinFirstElement,parameters_.DistanceNumMaxFirstElement,
+			seed, corridorIndex_, parameterIndex_, 0, 0));
 	// spline parameter t
 	double t = 0.0;
 	// position and  derivation for current t value
@@ -336,8 +343,10 @@ void DunGen::CCorridor::PlaceDetailObject(const SDetailobjectParameters& paramet
 		newDetailObject->Rotation.push_back((splineRotationMatrix*basicRotationMatrix).getRotationDegrees());
 
 		// compute new distance factor
-		distanceFactor = parameters_.DistanceNumFactor*
-			randomGenerator_->GetRandomNumberMinMax(parameters_.DistanceNumMin,parameters_.DistanceNumMax);
+		distanceFactor = parameters_.DistanceNumFactor*(legacyMode
+			? randomGenerator_->GetRandomNumberMinMax(parameters_.DistanceNumMin,parameters_.DistanceNumMax)
+			: randomGenerator_->GetHashNumberMinMax(parameters_.DistanceNumMin,parameters_.DistanceNumMax,
+				seed, corridorIndex_, parameterIndex_, static_cast<unsigned int>(newDetailObject->Position.size()), 0));
 	}
 
 	// go on further on the spline
@@ -375,8 +384,10 @@ void DunGen::CCorridor::PlaceDetailObject(const SDetailobjectParameters& paramet
 			newDetailObject->Rotation.push_back((splineRotationMatrix*basicRotationMatrix).getRotationDegrees());
 
 			// compute new distance factor
-			distanceFactor = parameters_.DistanceNumFactor*
-				randomGenerator_->GetRandomNumberMinMax(parameters_.DistanceNumMin,parameters_.DistanceNumMax);
+			distanceFactor = parameters_.DistanceNumFactor*(legacyMode
+				? randomGenerator_->GetRandomNumberMinMax(parameters_.DistanceNumMin,parameters_.DistanceNumMax)
+				: randomGenerator_->GetHashNumberMinMax(parameters_.DistanceNumMin,parameters_.DistanceNumMax,
+					seed, corridorIndex_, parameterIndex_, static_cast<unsigned int>(newDetailObject->Position.size()), 0));
 		}
 	}
 	
@@ -63,8 +63,11 @@ namespace DunGen
 		/// first element is placed in distance DistanceSampling*DistanceNumFactor*[DistanceNumMinFirstElement,DistanceNumMaxFirstElement] from position0
 		/// if ObjectAtT1, an object is placed at position1, even if the distance to the last object would be too small
 		///
+		/// the indices of corridor and parameters select the random numbers of the hash generator (not used in legacy mode)
+		///
 		/// important: Max>=Min, DistanceNumMin>=1, DistanceNumMinFirstElement>=0
-		void PlaceDetailObject(const SDetailobjectParameters& parameters_, const CRandomGenerator* randomGenerator_);
+		void PlaceDetailObject(const SDetailobjectParameters& parameters_, const CRandomGenerator* randomGenerator_,
+			unsigned int corridorIndex_, unsigned int parameterIndex_);
 
 		/// is the corridor sight blocking: do one can not see from one end to the other?
 		bool GetDefinitivelySightBlocking();
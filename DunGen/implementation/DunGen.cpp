@@ -9,6 +9,7 @@
 #include "MaterialProvider.h"
 #include "MeshCave.h"
 #include "VoxelCave.h"
+#include <limits.h>
 
 DunGen::CDunGen::CDunGen(irr::IrrlichtDevice* irrDevice)
 : DungeonGenerator(NULL)
@@ -64,13 +65,25 @@ void DunGen::CDunGen::CreateVoxelCave()
 void DunGen::CDunGen::ErodeVoxelCave(double erosionLikelihood)
 {
 	if (DungeonGenerator)
-		DungeonGenerator->ErodeVoxelCave(erosionLikelihood);
+		DungeonGenerator->ErodeVoxelCave(erosionLikelihood, 1);
+}
+
+void DunGen::CDunGen::ErodeVoxelCave(double erosionLikelihood, unsigned int iterations)
+{
+	if (DungeonGenerator)
+		DungeonGenerator->ErodeVoxelCave(erosionLikelihood, iterations);
 }
 
 void DunGen::CDunGen::RemoveHoveringVoxelFragments()
 {
 	if (DungeonGenerator)
-		DungeonGenerator->RemoveHoveringVoxelFragments();
+		DungeonGenerator->RemoveHoveringVoxelFragments(UINT_MAX);
+}
+
+void DunGen::CDunGen::RemoveHoveringVoxelFragments(unsigned int maxFragmentSize)
+{
+	if (DungeonGenerator)
+		DungeonGenerator->RemoveHoveringVoxelFragments(maxFragmentSize);
 }
 
 void DunGen::CDunGen::CreateMeshCave()
@@ -147,6 +160,12 @@ void DunGen::CDunGen::RandomGeneratorSetParameters(unsigned int seed, unsigned i
 		DungeonGenerator->RandomGeneratorSetParameters(seed, a, c, m);
 }
 
+void DunGen::CDunGen::RandomGeneratorSetLegacyMode(bool legacyMode)
+{
+	if (DungeonGenerator)
+		DungeonGenerator->RandomGeneratorSetLegacyMode(legacyMode);
+}
+
 void DunGen::CDunGen::LSystemAddRule(char symbol, const std::string& substitution)
 {
 	if (DungeonGenerator)
@@ -171,6 +190,30 @@ void DunGen::CDunGen::LSystemSetParameter(ELSystemParameter::Enum parameter, dou
 		DungeonGenerator->GetLSystem()->SetParameter(parameter, value);
 }
 
+void DunGen::CDunGen::LSystemSetMaxLength(unsigned int maxLength)
+{
+	if (DungeonGenerator)
+		DungeonGenerator->GetLSystem()->SetMaxLength(maxLength);
+}
+
+double DunGen::CDunGen::LSystemPredictLength(unsigned int derivation) const
+{
+	if (!DungeonGenerator)
+		return 0.0;
+
+	std::vector<double> lengths;
+	DungeonGenerator->GetLSystem()->PredictLengths(derivation, lengths);
+	return lengths[derivation];
+}
+
+bool DunGen::CDunGen::LSystemPredictBoundingBox(unsigned int derivation, irr::core::vector3d<double>& min, irr::core::vector3d<double>& max) const
+{
+	if (DungeonGenerator)
+		return DungeonGenerator->GetLSystem()->PredictBoundingBox(derivation, min, max);
+	else
+		return false;
+}
+
 void DunGen::CDunGen::VoxelCaveSetParameters(unsigned int border, unsigned int mindrawradius)
 {
 	if (DungeonGenerator)
@@ -180,7 +223,34 @@ void DunGen::CDunGen::VoxelCaveSetParameters(unsigned int border, unsigned int m
 	}
 }
 
-unsigned int DunGen::CDunGen::VoxelCaveEstimateMeshComplexity() const
+void DunGen::CDunGen::VoxelCaveSetDimensions(unsigned int dimX, unsigned int dimY, unsigned int dimZ)
+{
+	if (DungeonGenerator)
+		DungeonGenerator->GetVoxelCave()->SetDimensions(dimX, dimY, dimZ);
+}
+
+void DunGen::CDunGen::VoxelCaveSetDistanceField(bool enabled)
+{
+	if (DungeonGenerator)
+		DungeonGenerator->GetVoxelCave()->SetDistanceFieldEnabled(enabled);
+}
+
+void DunGen::CDunGen::VoxelCaveSetFilterMode(EFilterMode::Enum value)
+{
+	if (DungeonGenerator)
+		DungeonGenerator->GetVoxelCave()->SetFilterMode(value);
+}
+
+irr::core::vector3d<unsigned int> DunGen::CDunGen::VoxelCaveGetDimensions() const
+{
+	if (DungeonGenerator)
+		return irr::core::vector3d<unsigned int>(DungeonGenerator->GetVoxelCave()->GetDimX(),
+			DungeonGenerator->GetVoxelCave()->GetDimY(), DungeonGenerator->GetVoxelCave()->GetDimZ());
+	else
+		return irr::core::vector3d<unsigned int>(0,0,0);
+}
+
+unsigned int DunGen::CDunGen::VoxelCaveEstimateMeshComplexity()
 {
 	if (DungeonGenerator)
 		return DungeonGenerator->GetVoxelCave()->EstimateMeshComplexity();
@@ -188,6 +258,59 @@ unsigned int DunGen::CDunGen::VoxelCaveEstimateMeshComplexity() const
 		return 0;
 }
 
+unsigned int DunGen::CDunGen::VoxelCaveGetClearedBytes() const
+{
+	if (DungeonGenerator)
+		return DungeonGenerator->GetVoxelCave()->GetClearedBytes();
+	else
+		return 0;
+}
+
+unsigned int DunGen::CDunGen::VoxelCaveGetTurtlePeakDepth() const
+{
+	if (DungeonGenerator)
+		return DungeonGenerator->GetVoxelCave()->GetTurtlePeakDepth();
+	else
+		return 0;
+}
+
+unsigned int DunGen::CDunGen::VoxelCaveGetFilterPeakFrontier() const
+{
+	if (DungeonGenerator)
+		return DungeonGenerator->GetVoxelCave()->GetFilterPeakFrontier();
+	else
+		return 0;
+}
+
+unsigned int DunGen::CDunGen::VoxelCaveGetFragmentCount() const
+{
+	// the first component is the one connected to the border
+	if (DungeonGenerator && !DungeonGenerator->GetVoxelCave()->GetFragmentSizes().empty())
+		return static_cast<unsigned int>(DungeonGenerator->GetVoxelCave()->GetFragmentSizes().size())-1;
+	else
+		return 0;
+}
+
+unsigned int DunGen::CDunGen::VoxelCaveGetFragmentSize(unsigned int index) const
+{
+	if (DungeonGenerator && index+1 < DungeonGenerator->GetVoxelCave()->GetFragmentSizes().size())
+		return DungeonGenerator->GetVoxelCave()->GetFragmentSizes()[index+1];
+	else
+		return 0;
+}
+
+unsigned int DunGen::CDunGen::VoxelCaveGetCavePartCount() const
+{
+	if (DungeonGenerator)
+	{
+		std::vector<unsigned int> sizes;
+		DungeonGenerator->GetVoxelCave()->ComputeComponentSizes(1,sizes);
+		return static_cast<unsigned int>(sizes.size());
+	}
+	else
+		return 0;
+}
+
 void DunGen::CDunGen::MeshCaveSetWarpParameters(bool warpEnabled, bool smoothEnabled, unsigned int warpRandomSeed, double warpStrength)
 {
 	if (DungeonGenerator)
@@ -269,8 +392,16 @@ void DunGen::CDunGen::SetPrintToConsole(bool value)
 		DungeonGenerator->SetPrintToConsole(value);
 }
 
-unsigned char (&DunGen::CDunGen::GetVoxelSpace())[SVoxelSpace::DimX][SVoxelSpace::DimY][SVoxelSpace::DimZ]
+void DunGen::CDunGen::VoxelCaveSetVoxel(unsigned int x, unsigned int y, unsigned int z, unsigned char value)
+{
+	if (DungeonGenerator)
+		DungeonGenerator->GetVoxelCave()->SetVoxel(x, y, z, value);
+}
+
+unsigned char DunGen::CDunGen::VoxelCaveGetVoxel(unsigned int x, unsigned int y, unsigned int z) const
 {
-	// no test for DungeonGenerator here, what shall we return if it doesn't exist?
-	return DungeonGenerator->GetVoxelCave()->GetVoxelSpace();
+	if (DungeonGenerator)
+		return DungeonGenerator->GetVoxelCave()->GetVoxel(x, y, z);
+	else
+		return 0;
 }
\ No newline at end of file
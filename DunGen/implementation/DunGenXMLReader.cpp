@@ -4,6 +4,7 @@
 
 #include "interface/DunGen.h"
 #include "DunGenXMLReader.h"
+#include "LSystem.h"
 #include <string>
 
 DunGen::CDunGenXMLReader::CDunGenXMLReader(irr::IrrlichtDevice* irrDevice_, CDunGen* dunGen_)
@@ -55,7 +56,7 @@ bool DunGen::CDunGenXMLReader::Read( const irr::io::path& filename_ )
 			if (irr::core::stringw("Materials") == XmlReader->getNodeName())
 				ReadMaterials();
 			else if (irr::core::stringw("RandomGenerator") == XmlReader->getNodeName())
-				ReadWarpOptions();
+				ReadRandomGenerator();
 			else if (irr::core::stringw("WarpOptions") == XmlReader->getNodeName())
 				ReadWarpOptions();
 			else if (irr::core::stringw("DrawVoxelCave") == XmlReader->getNodeName())
@@ -128,6 +129,7 @@ void DunGen::CDunGenXMLReader::ReadRandomGenerator()
 		XmlReader->getAttributeValueAsInt(L"A"),
 		XmlReader->getAttributeValueAsInt(L"C"),
 		XmlReader->getAttributeValueAsInt(L"M"));
+	DunGenInterface->RandomGeneratorSetLegacyMode(irr::core::stringw("1") == XmlReader->getAttributeValue(L"Legacy"));
 }
 
 void DunGen::CDunGenXMLReader::ReadWarpOptions()
@@ -150,6 +152,9 @@ void DunGen::CDunGenXMLReader::ReadDrawVoxelCave()
 
 	DunGenInterface->LSystemSetParameter(ELSystemParameter::RADIUS_START, XmlReader->getAttributeValueAsFloat(L"StartRadius"));
 	unsigned int derivation = XmlReader->getAttributeValueAsInt(L"Derivation");
+	// default maximum length, if none or a negative one is given
+	const int maxLength = XmlReader->getAttributeValue(L"MaxLength") ? XmlReader->getAttributeValueAsInt(L"MaxLength") : -1;
+	DunGenInterface->LSystemSetMaxLength((maxLength >= 0) ? static_cast<unsigned int>(maxLength) : CLSystem::MAX_SIZE);
 
 	while(XmlReader->read() && (XmlReader->getNodeType() != irr::io::EXN_ELEMENT_END || irr::core::stringw("DrawVoxelCave") != XmlReader->getNodeName()) )
     {
@@ -159,6 +164,17 @@ void DunGen::CDunGenXMLReader::ReadDrawVoxelCave()
 			{
 				DunGenInterface->VoxelCaveSetParameters(XmlReader->getAttributeValueAsInt(L"VoxelBorder"),
 					XmlReader->getAttributeValueAsInt(L"MinDrawRadius"));
+				// the dimensions and the distance field keep their current settings (e.g. set by the application), if not given
+				if (XmlReader->getAttributeValue(L"DistanceField"))
+					DunGenInterface->VoxelCaveSetDistanceField(irr::core::stringw("1") == XmlReader->getAttributeValue(L"DistanceField"));
+			}
+			else if (irr::core::stringw("Dimensions") == XmlReader->getNodeName())
+			{
+				// the dimensions, that are not given, keep their current settings
+				const irr::core::vector3d<unsigned int> dimensions = DunGenInterface->VoxelCaveGetDimensions();
+				DunGenInterface->VoxelCaveSetDimensions(ReadDimension(L"X", dimensions.X),
+					ReadDimension(L"Y", dimensions.Y),
+					ReadDimension(L"Z", dimensions.Z));
 			}
 			else if (irr::core::stringw("Radius") == XmlReader->getNodeName())
 			{
@@ -187,14 +203,47 @@ void DunGen::CDunGenXMLReader::ReadDrawVoxelCave()
 	DunGenInterface->CreateVoxelCave();
 }
 
+unsigned int DunGen::CDunGenXMLReader::ReadDimension(const wchar_t* name_, unsigned int current_)
+{
+	if (!XmlReader->getAttributeValue(name_))
+		return current_;
+
+	// negative values are clamped to 0 (the voxel cave raises it to the minimum dimension)
+	const int value = XmlReader->getAttributeValueAsInt(name_);
+	return (value > 0) ? static_cast<unsigned int>(value) : 0;
+}
+
 void DunGen::CDunGenXMLReader::ReadErode()
 {
-	DunGenInterface->ErodeVoxelCave(XmlReader->getAttributeValueAsFloat(L"Likelihood"));	
+	// 1 iteration, if none is given (negative values are clamped to 0)
+	unsigned int iterations = 1;
+	if (XmlReader->getAttributeValue(L"Iterations"))
+	{
+		const int value = XmlReader->getAttributeValueAsInt(L"Iterations");
+		iterations = (value > 0) ? static_cast<unsigned int>(value) : 0;
+	}
+
+	DunGenInterface->ErodeVoxelCave(XmlReader->getAttributeValueAsFloat(L"Likelihood"), iterations);
 }
 
 void DunGen::CDunGenXMLReader::ReadFilter()
 {
-	DunGenInterface->RemoveHoveringVoxelFragments();
+	// the filter mode is only changed, if a valid one is given
+	if (XmlReader->getAttributeValue(L"Mode"))
+	{
+		const int mode = XmlReader->getAttributeValueAsInt(L"Mode");
+		if (EFilterMode::COMPONENTS == mode || EFilterMode::OUTER_HULL == mode)
+			DunGenInterface->VoxelCaveSetFilterMode(static_cast<DunGen::EFilterMode::Enum>(mode));
+	}
+
+	// all fragments are removed, if no maximum size is given (negative values are clamped to 0)
+	if (XmlReader->getAttributeValue(L"MaxFragmentSize"))
+	{
+		const int value = XmlReader->getAttributeValueAsInt(L"MaxFragmentSize");
+		DunGenInterface->RemoveHoveringVoxelFragments((value > 0) ? static_cast<unsigned int>(value) : 0);
+	}
+	else
+		DunGenInterface->RemoveHoveringVoxelFragments();
 }
 
 void DunGen::CDunGenXMLReader::ReadGenerateMeshCave()
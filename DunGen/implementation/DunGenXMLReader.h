@@ -39,6 +39,9 @@ namespace DunGen
 		/// process 'DrawVoxelCave' block
 		void ReadDrawVoxelCave();
 
+		/// read a dimension of the voxel space: current_, if not given, negative values are clamped to 0
+		unsigned int ReadDimension(const wchar_t* name_, unsigned int current_);
+
 		/// process 'Erode' block
 		void ReadErode();
 
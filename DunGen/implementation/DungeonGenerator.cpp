@@ -88,6 +88,12 @@ void DunGen::CDungeonGenerator::RandomGeneratorSetParameters(
 	RandomGenerator->SetA(a_);
 	RandomGenerator->SetC(c_);
 	RandomGenerator->SetM(m_);
+	RandomGenerator->SetHashSeed(seed_);
+}
+
+void DunGen::CDungeonGenerator::RandomGeneratorSetLegacyMode(bool legacyMode_)
+{
+	RandomGenerator->SetLegacyMode(legacyMode_);
 }
 
 unsigned int DunGen::CDungeonGenerator::CreateLSystemDerivation(unsigned int desiredIteration_)
@@ -117,8 +123,12 @@ void DunGen::CDungeonGenerator::CreateVoxelCave()
 		Timer->Start(0);
 	}
 
-	// draw the last derivation of the L-system in voxel space
-	VoxelCave->Draw(LSystem->GetHighestDerivation()
+	// draw the last derivation of the L-system in voxel space (expanded symbol by symbol while drawing)
+	CLSystemExpansion expansion = LSystem->GetHighestExpansion();
+	// the predicted turtle graphic sizes the turtle stack and spares interpreting big graphics twice
+	CLSystem::STurtlePrediction prediction;
+	LSystem->PredictTurtleGraphic(LSystem->GetDerivation(), prediction);
+	VoxelCave->Draw(expansion, &prediction
 		, LSystem->GetParameter(ELSystemParameter::ANGLE_YAW)
 		, LSystem->GetParameter(ELSystemParameter::ANGLE_PITCH)
 		, LSystem->GetParameter(ELSystemParameter::ANGLE_ROLL)
@@ -133,7 +143,7 @@ void DunGen::CDungeonGenerator::CreateVoxelCave()
 	}
 }
 
-void DunGen::CDungeonGenerator::ErodeVoxelCave(double erosionLikelihood_)
+void DunGen::CDungeonGenerator::ErodeVoxelCave(double erosionLikelihood_, unsigned int iterations_)
 {
 	if (PrintToConsole)
 	{
@@ -141,7 +151,7 @@ void DunGen::CDungeonGenerator::ErodeVoxelCave(double erosionLikelihood_)
 		Timer->Start(0);
 	}
 
-	VoxelCave->Erode(erosionLikelihood_);
+	VoxelCave->Erode(erosionLikelihood_, iterations_);
 
 	if (PrintToConsole)
 	{
@@ -150,7 +160,7 @@ void DunGen::CDungeonGenerator::ErodeVoxelCave(double erosionLikelihood_)
 	}
 }
 
-void DunGen::CDungeonGenerator::RemoveHoveringVoxelFragments()
+void DunGen::CDungeonGenerator::RemoveHoveringVoxelFragments(unsigned int maxFragmentSize_)
 {
 	if (PrintToConsole)
 	{
@@ -158,11 +168,16 @@ void DunGen::CDungeonGenerator::RemoveHoveringVoxelFragments()
 		Timer->Start(0);
 	}
 
-	unsigned int numRemovedVoxels = VoxelCave->Filter();
+	unsigned int numRemovedVoxels = VoxelCave->Filter(maxFragmentSize_);
 
 	if (PrintToConsole)
 	{
-		std::cout << "[VoxelCave:] completed , removed voxels = " << numRemovedVoxels << " , ";
+		std::cout << "[VoxelCave:] completed , removed voxels = " << numRemovedVoxels;
+		if (!VoxelCave->GetFragmentSizes().empty())
+			std::cout << " , fragments = " << VoxelCave->GetFragmentSizes().size()-1;
+		else
+			std::cout << " , peak frontier = " << VoxelCave->GetFilterPeakFrontier() << " runs";
+		std::cout << " , ";
 		Timer->Stop(0);
 	}
 }
@@ -409,7 +424,7 @@ bool DunGen::CDungeonGenerator::CreateCorridorRoomRoom(
 		CorrdidorDistance, CorrdidorTextureDistance);
 
 	for (unsigned int i=0; i<DetailobjectParameters.size(); ++i)
-		corridor->PlaceDetailObject(DetailobjectParameters[i], RandomGenerator);
+		corridor->PlaceDetailObject(DetailobjectParameters[i], RandomGenerator, static_cast<unsigned int>(Corridors.size()), i);
 
 	Corridors.push_back(corridor);
 	sightBlocking_ = corridor->GetDefinitivelySightBlocking();
@@ -445,7 +460,7 @@ bool DunGen::CDungeonGenerator::CreateCorridorRoomCave(
 		CorrdidorDistance, CorrdidorTextureDistance);
 
 	for (unsigned int i=0; i<DetailobjectParameters.size(); ++i)
-		corridor->PlaceDetailObject(DetailobjectParameters[i], RandomGenerator);
+		corridor->PlaceDetailObject(DetailobjectParameters[i], RandomGenerator, static_cast<unsigned int>(Corridors.size()), i);
 
 	Corridors.push_back(corridor);
 	sightBlocking_ = corridor->GetDefinitivelySightBlocking();
@@ -479,7 +494,7 @@ bool DunGen::CDungeonGenerator::CreateCorridorCaveCave(
 		CorrdidorDistance, CorrdidorTextureDistance);
 
 	for (unsigned int i=0; i<DetailobjectParameters.size(); ++i)
-		corridor->PlaceDetailObject(DetailobjectParameters[i], RandomGenerator);
+		corridor->PlaceDetailObject(DetailobjectParameters[i], RandomGenerator, static_cast<unsigned int>(Corridors.size()), i);
 
 	Corridors.push_back(corridor);
 	sightBlocking_ = corridor->GetDefinitivelySightBlocking();
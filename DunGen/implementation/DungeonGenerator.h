@@ -49,10 +49,10 @@ namespace DunGen
 		// Voxel cave creation functions:
 		/// Creates the voxel cave from the currently generated L-system iteration.
 		void CreateVoxelCave();
-		/// Erodes the voxel cave 1 voxel deep. Can be applied muliple times.
-		void ErodeVoxelCave(double erosionLikelihood_);
-		/// Removes all hovering fragments.
-		void RemoveHoveringVoxelFragments();
+		/// Erodes the voxel cave 1 voxel deep per iteration. Can be applied muliple times.
+		void ErodeVoxelCave(double erosionLikelihood_, unsigned int iterations_);
+		/// Removes the hovering fragments with at most maxFragmentSize_ voxels.
+		void RemoveHoveringVoxelFragments(unsigned int maxFragmentSize_);
 
 		// Mesh cave creation functions:
 		/// Creates the mesh cave from the currently generated voxel cave.
@@ -100,6 +100,8 @@ namespace DunGen
 
 		/// Set the parameters for the random generator: linear congruential generator, X[i+1] = (a*X[i]+c) mod m).
 		void RandomGeneratorSetParameters(unsigned int seed_, unsigned int a_, unsigned int c_, unsigned int m_);
+		/// Enables the legacy mode of the random generator (sequential numbers of the linear congruential generator instead of the hash generator).
+		void RandomGeneratorSetLegacyMode(bool legacyMode_);
 
 		// Corridor parameters:
 		/// Sets the distances for the corridor.
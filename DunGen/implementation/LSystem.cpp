@@ -4,20 +4,26 @@
 
 #include "LSystem.h"
 #include "Helperfunctions.h"
+#include <algorithm>
+#include <math.h>
 
 // ======================================================
 // constructor / destructor
 // ======================================================
 
 DunGen::CLSystem::CLSystem()
-	: AngleYaw(5.0)
+	: Start("F")
+	, Derivation(0)
+	, MaxLength(MAX_SIZE)
+	, AngleYaw(5.0)
 	, AnglePitch(5.0)
 	, AngleRoll(5.0)
 	, RadiusStart(10.0)
 	, RadiusFactor(1.0)
 	, RadiusDecrement(1.0)	
 {
-	Derivations.push_back("F");
+	for (unsigned int i=0; i<SYMBOL_COUNT; ++i)
+		RuleIndices[i] = -1;
 }
 
 DunGen::CLSystem::~CLSystem()
@@ -30,14 +36,17 @@ DunGen::CLSystem::~CLSystem()
 
 void DunGen::CLSystem::AddRule(char symbol_, const std::string& substitution_)
 {
+	// the turtle transforms depend on the rules
+	ClearTurtleTransforms();
+
 	// search, if symbol already present
-	for(unsigned int i=0; i<SubstitutionRules.size(); ++i)
-		if (symbol_ == SubstitutionRules[i].Symbol)
-		{
-			// if present, then actualize
-			SubstitutionRules[i].Substitution = substitution_;
-			return;
-		}
+	int& ruleIndex = RuleIndices[static_cast<unsigned char>(symbol_)];
+	if (ruleIndex >= 0)
+	{
+		// if present, then actualize
+		SubstitutionRules[ruleIndex].Substitution = substitution_;
+		return;
+	}
 	
 	// else: add symbol
 	// construct new rule
@@ -45,18 +54,22 @@ void DunGen::CLSystem::AddRule(char symbol_, const std::string& substitution_)
 	newRule.Symbol = symbol_;
 	newRule.Substitution = substitution_;
 	// add this rule
+	ruleIndex = static_cast<int>(SubstitutionRules.size());
 	SubstitutionRules.push_back(newRule);
 }
 void DunGen::CLSystem::DeleteRules()
 {
 	// delete all rules
 	SubstitutionRules.clear();
+	ClearTurtleTransforms();
+	for (unsigned int i=0; i<SYMBOL_COUNT; ++i)
+		RuleIndices[i] = -1;
 }
 void DunGen::CLSystem::SetStart(const std::string& start_)
 {
 	// store new value
-	Derivations.clear();
-	Derivations.push_back(start_);	
+	Start = start_;
+	Derivation = 0;
 }
 void DunGen::CLSystem::SetParameter(ELSystemParameter::Enum parameter_, double value_)
 {
@@ -70,21 +83,27 @@ void DunGen::CLSystem::SetParameter(ELSystemParameter::Enum parameter_, double v
 		case ELSystemParameter::RADIUS_FACTOR:		RadiusFactor=value_;		break;
 		case ELSystemParameter::RADIUS_DECREMENT:	RadiusDecrement=value_;		break;
 	}
+
+	// the turtle transforms depend on the angles
+	ClearTurtleTransforms();
+}
+void DunGen::CLSystem::SetMaxLength(unsigned int maxLength_)
+{
+	MaxLength = maxLength_;
+}
+void DunGen::CLSystem::ClearTurtleTransforms()
+{
+	SymbolTransforms.clear();
+	RuleTransforms.clear();
 }
 
 // ======================================================
 // reading parameters and results
 // ======================================================
 
-std::string DunGen::CLSystem::GetHighestDerivation()
+DunGen::CLSystemExpansion DunGen::CLSystem::GetHighestExpansion() const
 {
-	// return last derivation
-	if (!Derivations.empty())
-		return Derivations.back();
-
-	// if no derivation available, return empty string
-	const std::string tmp;
-	return tmp;
+	return CLSystemExpansion(*this, Derivation);
 }
 
 double DunGen::CLSystem::GetParameter(ELSystemParameter::Enum parameter_)
@@ -104,60 +123,526 @@ double DunGen::CLSystem::GetParameter(ELSystemParameter::Enum parameter_)
 }
 
 // ======================================================
-// generating strings
+// generation L-system derivations
+// ======================================================
+unsigned int DunGen::CLSystem::GenerateDerivations(unsigned int maxIterations_)
+{
+	// without limit, all derivations are available
+	Derivation = maxIterations_;
+	if (0 == MaxLength)
+		return Derivation+1;
+
+	// break iteration, if string too large
+	std::vector<double> lengths;
+	PredictLengths(maxIterations_, lengths);
+	for (unsigned int i=1; i<lengths.size(); ++i)
+		if (static_cast<double>(MaxLength) < lengths[i])
+		{
+			Derivation = i-1;
+			break;
+		}
+
+	// return the number of derivations
+	return Derivation+1;
+}
+
+// ======================================================
+// predicting L-system derivations
 // ======================================================
 
-inline std::string DunGen::CLSystem::Replace(const std::string& baseString_)
+void DunGen::CLSystem::ComputeCountMatrix(std::vector<std::vector<SSymbolCount> >& matrix_) const
 {
-	// initialize new string
-	std::string newString = "";
-	
-	// iterate over basestring
-	bool existsSubstitution;
-	for (unsigned int i=0; i<baseString_.size(); ++i)
+	matrix_.resize(SubstitutionRules.size());
+	for (unsigned int i=0; i<SubstitutionRules.size(); ++i)
+	{
+		// count the symbols of the substitution
+		std::vector<double> counts(SYMBOL_COUNT, 0.0);
+		const std::string& substitution = SubstitutionRules[i].Substitution;
+		for (unsigned int j=0; j<substitution.size(); ++j)
+			counts[static_cast<unsigned char>(substitution[j])] += 1.0;
+
+		// keep the non zero entries only
+		matrix_[i].clear();
+		for (unsigned int j=0; j<SYMBOL_COUNT; ++j)
+			if (counts[j] > 0.0)
+			{
+				SSymbolCount entry;
+				entry.Symbol = static_cast<unsigned char>(j);
+				entry.Count = counts[j];
+				matrix_[i].push_back(entry);
+			}
+	}
+}
+
+void DunGen::CLSystem::ApplyCountMatrix(const std::vector<std::vector<SSymbolCount> >& matrix_, std::vector<double>& counts_) const
+{
+	std::vector<double> newCounts(SYMBOL_COUNT, 0.0);
+	for (unsigned int i=0; i<SYMBOL_COUNT; ++i)
+	{
+		if (0.0 == counts_[i])
+			continue;
+
+		// symbols without rule are substituted by themselves
+		const int rule = RuleIndices[i];
+		if (rule < 0)
+		{
+			newCounts[i] += counts_[i];
+			continue;
+		}
+
+		const std::vector<SSymbolCount>& row = matrix_[rule];
+		for (unsigned int j=0; j<row.size(); ++j)
+			newCounts[row[j].Symbol] += counts_[i] * row[j].Count;
+	}
+	counts_.swap(newCounts);
+}
+
+void DunGen::CLSystem::PredictLengths(unsigned int maxIterations_, std::vector<double>& lengths_) const
+{
+	std::vector<std::vector<SSymbolCount> > matrix;
+	ComputeCountMatrix(matrix);
+
+	// symbol counts of the start (double: the counts grow exponentially)
+	std::vector<double> counts(SYMBOL_COUNT, 0.0);
+	for (unsigned int i=0; i<Start.size(); ++i)
+		counts[static_cast<unsigned char>(Start[i])] += 1.0;
+
+	lengths_.resize(maxIterations_+1);
+	for (unsigned int i=0; i<=maxIterations_; ++i)
+	{
+		// the length is the sum of the symbol counts
+		lengths_[i] = 0.0;
+		for (unsigned int j=0; j<SYMBOL_COUNT; ++j)
+			lengths_[i] += counts[j];
+
+		if (i < maxIterations_)
+			ApplyCountMatrix(matrix, counts);
+	}
+}
+
+bool DunGen::CLSystem::PredictTurtleGraphic(unsigned int derivation_, STurtlePrediction& prediction_) const
+{
+	// the transforms can be composed, if every string leaves the turtle stack unchanged and no absolute orientation ('$') is used
+	bool composable = IsComposable(Start);
+	for (unsigned int i=0; i<SubstitutionRules.size() && composable; ++i)
+		composable = IsComposable(SubstitutionRules[i].Substitution);
+
+	prediction_.MaxDepth = PredictMaxDepth(derivation_);
+	prediction_.Tight = composable;
+	if (!composable)
+	{
+		// the turtle can not move further than the number of lines, nor reduce the radius more than the number of reductions
+		std::vector<std::vector<SSymbolCount> > matrix;
+		ComputeCountMatrix(matrix);
+		std::vector<double> counts(SYMBOL_COUNT, 0.0);
+		for (unsigned int i=0; i<Start.size(); ++i)
+			counts[static_cast<unsigned char>(Start[i])] += 1.0;
+		for (unsigned int i=0; i<derivation_; ++i)
+			ApplyCountMatrix(matrix, counts);
+
+		prediction_.Lines = counts[static_cast<unsigned char>('F')];
+		prediction_.MaxReductions = static_cast<unsigned int>(std::min(counts[static_cast<unsigned char>('!')], 4294967295.0));
+		prediction_.Min.set(-prediction_.Lines,-prediction_.Lines,-prediction_.Lines);
+		prediction_.Max.set(prediction_.Lines,prediction_.Lines,prediction_.Lines);
+		return false;
+	}
+
+	// the derivation is the start expanded derivation_ times
+	UpdateTurtleTransforms(derivation_);
+	STurtleTransform transform;
+	ComposeTransforms(Start, derivation_, transform);
+
+	// the turtle graphic starts at the origin
+	prediction_.Lines = transform.Lines;
+	prediction_.MaxReductions = transform.MaxReductions;
+	prediction_.Min.set(0.0,0.0,0.0);
+	prediction_.Max.set(0.0,0.0,0.0);
+	if (transform.Lines > 0.0)
+	{
+		prediction_.Min.set(std::min(transform.Min.X, 0.0), std::min(transform.Min.Y, 0.0), std::min(transform.Min.Z, 0.0));
+		prediction_.Max.set(std::max(transform.Max.X, 0.0), std::max(transform.Max.Y, 0.0), std::max(transform.Max.Z, 0.0));
+	}
+	return true;
+}
+
+bool DunGen::CLSystem::PredictBoundingBox(unsigned int derivation_, irr::core::vector3d<double>& min_, irr::core::vector3d<double>& max_) const
+{
+	STurtlePrediction prediction;
+	const bool tight = PredictTurtleGraphic(derivation_, prediction);
+	min_ = prediction.Min;
+	max_ = prediction.Max;
+	return tight;
+}
+
+double DunGen::CLSystem::PredictMaxDepth(unsigned int derivation_) const
+{
+	// effects of the symbols after 0 iterations: '[' pushes, ']' pops (if the stack is not empty)
+	SStackDepth identity;
+	identity.Shift = 0.0;
+	identity.Floor = 0.0;
+	identity.PeakShift = 0.0;
+	identity.PeakFloor = 0.0;
+	std::vector<SStackDepth> symbolDepths(SYMBOL_COUNT, identity);
+	symbolDepths[static_cast<unsigned char>('[')].Shift = 1.0;
+	symbolDepths[static_cast<unsigned char>('[')].Floor = 1.0;
+	symbolDepths[static_cast<unsigned char>('[')].PeakShift = 1.0;
+	symbolDepths[static_cast<unsigned char>('[')].PeakFloor = 1.0;
+	symbolDepths[static_cast<unsigned char>(']')].Shift = -1.0;
+
+	// effects of the symbols after i+1 iterations: composed from the effects of their substitution after i iterations
+	std::vector<SStackDepth> newSymbolDepths;
+	for (unsigned int i=0; i<derivation_; ++i)
 	{
-		existsSubstitution = false;
-		// find matching substitution
+		newSymbolDepths = symbolDepths;
 		for (unsigned int j=0; j<SubstitutionRules.size(); ++j)
-			if (baseString_[i] == SubstitutionRules[j].Symbol)
+			ComposeStackDepths(SubstitutionRules[j].Substitution, symbolDepths,
+				newSymbolDepths[static_cast<unsigned char>(SubstitutionRules[j].Symbol)]);
+		symbolDepths.swap(newSymbolDepths);
+	}
+
+	// the turtle starts with the empty stack
+	SStackDepth depth;
+	ComposeStackDepths(Start, symbolDepths, depth);
+	return std::max(depth.PeakShift, depth.PeakFloor);
+}
+
+void DunGen::CLSystem::ComposeStackDepths(const std::string& string_, const std::vector<SStackDepth>& symbolDepths_, SStackDepth& depth_) const
+{
+	depth_.Shift = 0.0;
+	depth_.Floor = 0.0;
+	depth_.PeakShift = 0.0;
+	depth_.PeakFloor = 0.0;
+
+	for (unsigned int i=0; i<string_.size(); ++i)
+	{
+		const SStackDepth& symbolDepth = symbolDepths_[static_cast<unsigned char>(string_[i])];
+
+		// maximum depth during the symbol, starting with the depth reached so far
+		depth_.PeakShift = std::max(depth_.PeakShift, depth_.Shift + symbolDepth.PeakShift);
+		depth_.PeakFloor = std::max(depth_.PeakFloor, std::max(depth_.Floor + symbolDepth.PeakShift, symbolDepth.PeakFloor));
+
+		// depth after the symbol
+		depth_.Floor = std::max(depth_.Floor + symbolDepth.Shift, symbolDepth.Floor);
+		depth_.Shift += symbolDepth.Shift;
+	}
+}
+
+void DunGen::CLSystem::UpdateTurtleTransforms(unsigned int depth_) const
+{
+	// transforms of the symbols without substitution
+	if (SymbolTransforms.empty())
+	{
+		SymbolTransforms.resize(SYMBOL_COUNT);
+		for (unsigned int i=0; i<SYMBOL_COUNT; ++i)
+			ComputeSymbolTransform(static_cast<char>(i), SymbolTransforms[i]);
+	}
+
+	// transforms of the rule symbols after d+1 iterations: composed from their substitution after d iterations
+	while (RuleTransforms.size() < depth_)
+	{
+		const unsigned int depth = RuleTransforms.size();
+		std::vector<STurtleTransform> ruleTransforms(SubstitutionRules.size());
+		for (unsigned int i=0; i<SubstitutionRules.size(); ++i)
+			ComposeTransforms(SubstitutionRules[i].Substitution, depth, ruleTransforms[i]);
+		RuleTransforms.push_back(ruleTransforms);
+	}
+}
+
+void DunGen::CLSystem::ComputeSymbolTransform(char symbol_, STurtleTransform& transform_) const
+{
+	// starting values
+	transform_.Position = irr::core::vector3d<double>(0.0,0.0,0.0);
+	transform_.Front = irr::core::vector3d<double>(1.0,0.0,0.0);
+	transform_.Up = irr::core::vector3d<double>(0.0,1.0,0.0);
+	transform_.Left = irr::core::vector3d<double>(0.0,0.0,1.0);
+	transform_.Min = irr::core::vector3d<double>(0.0,0.0,0.0);
+	transform_.Max = irr::core::vector3d<double>(0.0,0.0,0.0);
+	transform_.Lines = 0.0;
+	transform_.Reductions = 0;
+	transform_.MaxReductions = 0;
+
+	// the rotations are the same as for drawing the voxel cave (CVoxelCave::InterpretTurtleGraphic)
+	const double angleYawRAD = AngleYaw * M_DegToRad;
+	const double angleNickRAD = AnglePitch * M_DegToRad;
+	const double angleRollRAD = AngleRoll * M_DegToRad;
+
+	switch (symbol_)
+	{
+	case 'F': // draw line
+		transform_.Position = transform_.Front;
+		transform_.Min = transform_.Position;
+		transform_.Max = transform_.Position;
+		transform_.Lines = 1.0;
+		break;
+	case '!': // reduce radius
+		transform_.Reductions = 1;
+		transform_.MaxReductions = 1;
+		break;
+	case '+': // rotate around Up by AngleYaw (left)
+		transform_.Front = cos(angleYawRAD) * transform_.Front + sin(angleYawRAD) * transform_.Left;
+		transform_.Front.normalize();
+		transform_.Left = transform_.Front.crossProduct(transform_.Up);
+		transform_.Left.normalize();
+		break;
+	case '-': // rotate around Up by -AngleYaw (right)
+		transform_.Front = cos(angleYawRAD) * transform_.Front - sin(angleYawRAD) * transform_.Left;
+		transform_.Front.normalize();
+		transform_.Left = transform_.Front.crossProduct(transform_.Up);
+		transform_.Left.normalize();
+		break;
+	case 'u': // rotate around Left by AnglePitch (down)
+		transform_.Front = cos(angleNickRAD) * transform_.Front - sin(angleNickRAD) * transform_.Up;
+		transform_.Front.normalize();
+		transform_.Up = transform_.Left.crossProduct(transform_.Front);
+		transform_.Up.normalize();
+		break;
+	case 'o': // rotate around Left by -AnglePitch (up)
+		transform_.Front = cos(angleNickRAD) * transform_.Front + sin(angleNickRAD) * transform_.Up;
+		transform_.Front.normalize();
+		transform_.Up = transform_.Left.crossProduct(transform_.Front);
+		transform_.Up.normalize();
+		break;
+	case 'z': // rotate around Front by AngleRoll (clockwise)
+		transform_.Left = cos(angleRollRAD) * transform_.Left + sin(angleRollRAD) * transform_.Up;
+		transform_.Left.normalize();
+		transform_.Up = transform_.Left.crossProduct(transform_.Front);
+		transform_.Up.normalize();
+		break;
+	case 'g': // rotate around Front by AngleRoll (counterclockwise)
+		transform_.Left = cos(angleRollRAD) * transform_.Left - sin(angleRollRAD) * transform_.Up;
+		transform_.Left.normalize();
+		transform_.Up = transform_.Left.crossProduct(transform_.Front);
+		transform_.Up.normalize();
+		break;
+	case '|': // rotate around Up by 180 degrees
+		transform_.Front = -transform_.Front;
+		transform_.Left = -transform_.Left;
+		break;
+	}
+}
+
+void DunGen::CLSystem::ComposeTransforms(const std::string& string_, unsigned int depth_, STurtleTransform& transform_) const
+{
+	ComputeSymbolTransform(' ', transform_);
+
+	// turtle states saved by '['
+	std::vector<STurtleTransform> stateStack;
+
+	for (unsigned int i=0; i<string_.size(); ++i)
+	{
+		if ('[' == string_[i])
+		{
+			stateStack.push_back(transform_);
+			continue;
+		}
+		if (']' == string_[i])
+		{
+			// restore position, orientation and radius, keep the bounding box
+			if (!stateStack.empty())
+			{
+				transform_.Position = stateStack.back().Position;
+				transform_.Front = stateStack.back().Front;
+				transform_.Up = stateStack.back().Up;
+				transform_.Left = stateStack.back().Left;
+				transform_.Reductions = stateStack.back().Reductions;
+				stateStack.pop_back();
+			}
+			continue;
+		}
+
+		// the symbol transform is relative to the actual state: local X, Y, Z are Front, Up, Left
+		const int rule = RuleIndices[static_cast<unsigned char>(string_[i])];
+		const STurtleTransform& symbolTransform = (depth_ > 0 && rule >= 0)
+			? RuleTransforms[depth_-1][rule] : SymbolTransforms[static_cast<unsigned char>(string_[i])];
+
+		if (symbolTransform.Lines > 0.0)
+		{
+			// bounding box of the rotated box of the symbol
+			const irr::core::vector3d<double> center = 0.5*(symbolTransform.Min + symbolTransform.Max);
+			const irr::core::vector3d<double> halfSize = 0.5*(symbolTransform.Max - symbolTransform.Min);
+			const irr::core::vector3d<double> boxCenter = transform_.Position
+				+ center.X*transform_.Front + center.Y*transform_.Up + center.Z*transform_.Left;
+			const irr::core::vector3d<double> boxHalfSize(
+				fabs(transform_.Front.X)*halfSize.X + fabs(transform_.Up.X)*halfSize.Y + fabs(transform_.Left.X)*halfSize.Z,
+				fabs(transform_.Front.Y)*halfSize.X + fabs(transform_.Up.Y)*halfSize.Y + fabs(transform_.Left.Y)*halfSize.Z,
+				fabs(transform_.Front.Z)*halfSize.X + fabs(transform_.Up.Z)*halfSize.Y + fabs(transform_.Left.Z)*halfSize.Z);
+			const irr::core::vector3d<double> boxMin = boxCenter - boxHalfSize;
+			const irr::core::vector3d<double> boxMax = boxCenter + boxHalfSize;
+
+			if (transform_.Lines > 0.0)
 			{
-				// substitute
-				newString += SubstitutionRules[j].Substitution;
-				existsSubstitution = true;
-				// break the loop
-				j = SubstitutionRules.size();
+				transform_.Min.X = std::min(transform_.Min.X, boxMin.X);	transform_.Max.X = std::max(transform_.Max.X, boxMax.X);
+				transform_.Min.Y = std::min(transform_.Min.Y, boxMin.Y);	transform_.Max.Y = std::max(transform_.Max.Y, boxMax.Y);
+				transform_.Min.Z = std::min(transform_.Min.Z, boxMin.Z);	transform_.Max.Z = std::max(transform_.Max.Z, boxMax.Z);
 			}
-		// no substitution was matching: symbol is substituted by itself
-		if (!existsSubstitution) newString += baseString_[i];
+			else
+			{
+				transform_.Min = boxMin;
+				transform_.Max = boxMax;
+			}
+			transform_.Lines += symbolTransform.Lines;
+		}
+
+		// reduce radius
+		transform_.MaxReductions = std::max(transform_.MaxReductions, transform_.Reductions + symbolTransform.MaxReductions);
+		transform_.Reductions += symbolTransform.Reductions;
+
+		// move and rotate
+		transform_.Position += symbolTransform.Position.X*transform_.Front
+			+ symbolTransform.Position.Y*transform_.Up + symbolTransform.Position.Z*transform_.Left;
+		const irr::core::vector3d<double> front = symbolTransform.Front.X*transform_.Front
+			+ symbolTransform.Front.Y*transform_.Up + symbolTransform.Front.Z*transform_.Left;
+		const irr::core::vector3d<double> up = symbolTransform.Up.X*transform_.Front
+			+ symbolTransform.Up.Y*transform_.Up + symbolTransform.Up.Z*transform_.Left;
+		const irr::core::vector3d<double> left = symbolTransform.Left.X*transform_.Front
+			+ symbolTransform.Left.Y*transform_.Up + symbolTransform.Left.Z*transform_.Left;
+		transform_.Front = front;
+		transform_.Up = up;
+		transform_.Left = left;
+	}
+}
+
+bool DunGen::CLSystem::IsComposable(const std::string& string_) const
+{
+	int depth = 0;
+	for (unsigned int i=0; i<string_.size(); ++i)
+	{
+		if ('$' == string_[i])
+			return false;
+		if ('[' == string_[i])
+			++depth;
+		else if (']' == string_[i] && --depth < 0)
+			return false;
 	}
-			
-	// return result of substitution
-	return newString;
+	return 0 == depth;
 }
 
 // ======================================================
-// generation L-system derivations
+// lazy expansion of L-system derivations
 // ======================================================
-unsigned int DunGen::CLSystem::GenerateDerivations(unsigned int maxIterations_)
+
+DunGen::CLSystemExpansion::CLSystemExpansion()
+	: Derivation(0)
+	, Symbol(0)
+{
+	for (unsigned int i=0; i<CLSystem::SYMBOL_COUNT; ++i)
+		RuleIndices[i] = -1;
+}
+
+DunGen::CLSystemExpansion::CLSystemExpansion(const CLSystem& lSystem_, unsigned int derivation_)
+	: Start(lSystem_.Start)
+	, Derivation(derivation_)
+	, Symbol(0)
+{
+	// copy the rules, so the expansion does not depend on later changes of the L-system
+	for (unsigned int i=0; i<lSystem_.SubstitutionRules.size(); ++i)
+		RuleSubstitutions.push_back(lSystem_.SubstitutionRules[i].Substitution);
+	for (unsigned int i=0; i<CLSystem::SYMBOL_COUNT; ++i)
+		RuleIndices[i] = lSystem_.RuleIndices[i];
+
+	CreateBlocks();
+	Reset();
+}
+
+void DunGen::CLSystemExpansion::CreateBlocks()
+{
+	const unsigned int ruleCount = RuleSubstitutions.size();
+	Blocks.clear();
+	BlockIndices.assign((Derivation+1)*ruleCount, -1);
+
+	// lengths of the expanded substitutions with n-1 and n remaining expansions (double: the lengths grow exponentially)
+	std::vector<double> lengths(ruleCount);
+	std::vector<double> newLengths(ruleCount);
+	for (unsigned int i=0; i<ruleCount; ++i)
+		lengths[i] = static_cast<double>(RuleSubstitutions[i].size());
+
+	// without remaining expansion the substitution is read directly, blocks start at 1 remaining expansion
+	for (unsigned int n=1; n<Derivation; ++n)
+	{
+		for (unsigned int i=0; i<ruleCount; ++i)
+		{
+			const std::string& substitution = RuleSubstitutions[i];
+			newLengths[i] = 0.0;
+			for (unsigned int j=0; j<substitution.size(); ++j)
+			{
+				const int rule = RuleIndices[static_cast<unsigned char>(substitution[j])];
+				newLengths[i] += (rule < 0) ? 1.0 : lengths[rule];
+			}
+			if (newLengths[i] > static_cast<double>(BlockSize))
+				continue;
+
+			// the block is composed from the blocks of the level below (they are short enough too)
+			std::string block;
+			block.reserve(static_cast<unsigned int>(newLengths[i]));
+			for (unsigned int j=0; j<substitution.size(); ++j)
+			{
+				const int rule = RuleIndices[static_cast<unsigned char>(substitution[j])];
+				if (rule < 0)
+					block += substitution[j];
+				else if (1 == n)
+					block += RuleSubstitutions[rule];
+				else
+					block += Blocks[BlockIndices[(n-1)*ruleCount + rule]];
+			}
+			BlockIndices[n*ruleCount + i] = static_cast<int>(Blocks.size());
+			Blocks.push_back(block);
+		}
+		lengths.swap(newLengths);
+	}
+}
+
+void DunGen::CLSystemExpansion::Reset()
 {
-	// generate iteration strings
-	std::string actString = Derivations[0]; // iteration 0 = start
-	// only the start has to be here
-	Derivations.clear();
-	Derivations.push_back(actString);
+	// begin with the start string
+	Cursors.clear();
+	Cursors.reserve(Derivation+1);
+	SCursor cursor;
+	cursor.Rule = -1;
+	cursor.Block = -1;
+	cursor.Position = 0;
+	Cursors.push_back(cursor);
 
-	for (unsigned int i=0; i<maxIterations_; ++i)
-	{	
-		// replicate new string
-		actString = Replace(actString);
+	Advance();
+}
 
-		// break iteration, if string too large
-		if (MAX_SIZE<actString.size()) break;
+void DunGen::CLSystemExpansion::Advance()
+{
+	while (!Cursors.empty())
+	{
+		SCursor& cursor = Cursors.back();
+		const std::string& string = (cursor.Block >= 0) ? Blocks[cursor.Block]
+			: ((cursor.Rule < 0) ? Start : RuleSubstitutions[cursor.Rule]);
 
-		// add string to the derivation object
-		Derivations.push_back(actString);
+		// string of this level completed: continue in the level above
+		if (cursor.Position >= string.size())
+		{
+			Cursors.pop_back();
+			continue;
+		}
+		const char symbol = string[cursor.Position++];
+
+		// symbol of the derivation level reached, symbol of a block or symbol without substitution (it is substituted by itself in all levels)
+		const int rule = (cursor.Block < 0 && Cursors.size() <= Derivation) ? RuleIndices[static_cast<unsigned char>(symbol)] : -1;
+		if (rule < 0)
+		{
+			Symbol = symbol;
+			return;
+		}
+
+		// descend into the substitution (its block, if it is short enough)
+		SCursor next;
+		next.Rule = rule;
+		next.Block = BlockIndices[(Derivation - Cursors.size())*RuleSubstitutions.size() + rule];
+		next.Position = 0;
+		Cursors.push_back(next);
 	}
 
-	// return the number of iterations
-	return Derivations.size();
+	// end of the derivation
+	Symbol = 0;
+}
+
+bool DunGen::CLSystemExpansion::operator==(const CLSystemExpansion& other_) const
+{
+	return Derivation == other_.Derivation && Start == other_.Start && RuleSubstitutions == other_.RuleSubstitutions
+		&& std::equal(RuleIndices, RuleIndices+CLSystem::SYMBOL_COUNT, other_.RuleIndices);
 }
\ No newline at end of file
@@ -6,15 +6,22 @@
 #define LSYSTEM_H
 
 #include "interface/LSystemCommon.h"
+#include <irrlicht.h>
 #include <string>
 #include <vector>
 
 // Namespace DunGen : DungeonGenerator
 namespace DunGen
 {
+	class CLSystemExpansion;
+
 	/// generator for Lindenmayer systems (L-systems)
+	///
+	/// the derivations are not stored as strings: they are expanded symbol by symbol, when they are read (CLSystemExpansion)
 	class CLSystem
 	{
+		friend class CLSystemExpansion;
+
 	private:
 		/// substitution rule
 		struct SSubstitutionRule
@@ -23,20 +30,77 @@ namespace DunGen
 			std::string Substitution;	///< substition
 		};
 
+		/// number of occurrences of a symbol in a substitution (entry of the symbol count matrix)
+		struct SSymbolCount
+		{
+			unsigned char Symbol;		///< symbol
+			double Count;				///< number of occurrences
+		};
+
+		/// effect of the turtle graphic of an expanded symbol, relative to the turtle state before it
+		/// (the turtle starts at the origin with Front = X, Up = Y, Left = Z, F-length 1)
+		struct STurtleTransform
+		{
+			irr::core::vector3d<double> Position;	///< position after the expansion
+			irr::core::vector3d<double> Front;		///< front vector after the expansion
+			irr::core::vector3d<double> Up;			///< up vector after the expansion
+			irr::core::vector3d<double> Left;		///< left vector after the expansion
+			irr::core::vector3d<double> Min;		///< bounding box of the positions after the lines: minimum
+			irr::core::vector3d<double> Max;		///< bounding box of the positions after the lines: maximum
+			double Lines;							///< number of lines ('F'), 0 = no bounding box
+			unsigned int Reductions;				///< radius reductions ('!') after the expansion
+			unsigned int MaxReductions;				///< maximum radius reductions during the expansion
+		};
+
+		/// effect of an expanded symbol on the depth d of the turtle stack (a ']' on the empty stack is ignored):
+		/// depth after the expansion = max(d + Shift, Floor), maximum depth during the expansion = max(d + PeakShift, PeakFloor)
+		struct SStackDepth
+		{
+			double Shift;		///< depth change
+			double Floor;		///< minimum depth after the expansion
+			double PeakShift;	///< maximum depth change during the expansion
+			double PeakFloor;	///< minimum maximum depth during the expansion
+		};
+
+	public:
+		/// predicted turtle graphic of a derivation
+		struct STurtlePrediction
+		{
+			irr::core::vector3d<double> Min;		///< bounding box of the line ends and the origin: minimum
+			irr::core::vector3d<double> Max;		///< bounding box of the line ends and the origin: maximum
+			double Lines;							///< number of lines ('F')
+			unsigned int MaxReductions;				///< maximum radius reductions ('!')
+			double MaxDepth;						///< maximum depth of the turtle stack ('[', always exact)
+			bool Tight;								///< false, if the bounding box is only bounded by the number of lines ('$' or unbalanced brackets)
+		};
+
 	public:
 		/// constructor
 		CLSystem();
 		/// destructor
 		~CLSystem();
 
-		/// generate L-system derivations
+		/// generate L-system derivations (only their lengths are computed, to respect the maximum length)
 		unsigned int GenerateDerivations(unsigned int maxIterations_);
 
 		/// get parameter
 		double GetParameter(ELSystemParameter::Enum parameter_);
 
-		/// get the highest created derivation
-		std::string GetHighestDerivation();
+		/// get the highest created derivation (0 = start)
+		unsigned int GetDerivation() const {return Derivation;}
+		/// get a lazy expansion of the highest created derivation
+		CLSystemExpansion GetHighestExpansion() const;
+
+		/// predict the lengths of the derivations 0...maxIterations_ from the symbol count matrix of the rules (without creating them)
+		void PredictLengths(unsigned int maxIterations_, std::vector<double>& lengths_) const;
+		/// predict the bounding box of the turtle graphic of a derivation in F-lengths (without creating it),
+		/// the box contains the exact bounding box, it is composed from the boxes of the expanded symbols (in microseconds),
+		/// returns false, if the rules use '$' or unbalanced brackets: then the box is only bounded by the number of lines
+		bool PredictBoundingBox(unsigned int derivation_, irr::core::vector3d<double>& min_, irr::core::vector3d<double>& max_) const;
+		/// predict bounding box, number of lines and maximum radius reductions of the turtle graphic of a derivation,
+		/// composed from the memoized turtle transforms of the rule symbols per iteration (time: rule size * derivation),
+		/// returns false, if the rules use '$' or unbalanced brackets: then only bounds from the symbol counts are given (except the stack depth)
+		bool PredictTurtleGraphic(unsigned int derivation_, STurtlePrediction& prediction_) const;
 
 		/// add or actualize a substitution rule
 		void AddRule(char symbol_, const std::string& substitution_);
@@ -47,21 +111,50 @@ namespace DunGen
 		void SetStart(const std::string& start_);
 		/// set parameter
 		void SetParameter(ELSystemParameter::Enum parameter_, double value_);
+		/// set the maximum length of the generated derivations (0 = no limit)
+		void SetMaxLength(unsigned int maxLength_);
 
 	private:
-		/// replace by substitution rules
-		inline std::string Replace(const std::string& baseString_);
+		/// computes the symbol count matrix: row i holds the symbol counts of the substitution of rule i
+		void ComputeCountMatrix(std::vector<std::vector<SSymbolCount> >& matrix_) const;
+		/// applies one iteration to the symbol counts of a derivation
+		void ApplyCountMatrix(const std::vector<std::vector<SSymbolCount> >& matrix_, std::vector<double>& counts_) const;
 
-	private:
-		/// maximum string size for generated derivations
+		/// predicts the maximum depth of the turtle stack of a derivation
+		double PredictMaxDepth(unsigned int derivation_) const;
+		/// composes the effects on the turtle stack depth of the symbols of a string (the effects of the symbols are given)
+		void ComposeStackDepths(const std::string& string_, const std::vector<SStackDepth>& symbolDepths_, SStackDepth& depth_) const;
+		/// computes the memoized turtle transforms of the rule symbols up to depth_ iterations
+		void UpdateTurtleTransforms(unsigned int depth_) const;
+		/// releases the memoized turtle transforms (the rules or angles have changed)
+		void ClearTurtleTransforms();
+		/// computes the turtle transform of a symbol without substitution
+		void ComputeSymbolTransform(char symbol_, STurtleTransform& transform_) const;
+		/// composes the turtle transforms of the symbols of a string, every symbol expanded depth_ times (memoized up to depth_)
+		void ComposeTransforms(const std::string& string_, unsigned int depth_, STurtleTransform& transform_) const;
+		/// tests if the turtle transforms of the symbols of a string can be composed: no '$' and balanced brackets
+		bool IsComposable(const std::string& string_) const;
+
+	public:
+		/// default maximum length of the generated derivations (kept from the string based derivations: the expansion itself needs no memory per symbol,
+		/// but drawing keeps a primitive per line, SetMaxLength(0) lifts the limit)
 		static const unsigned int MAX_SIZE = 1000000;
+		/// number of different symbols
+		static const unsigned int SYMBOL_COUNT = 256;
 
+	private:
 		// parameters:
 
-		/// derivation (0 = start)
-		std::vector<std::string> Derivations;
+		/// start string (axiom)
+		std::string Start;
+		/// highest created derivation (0 = start)
+		unsigned int Derivation;
+		/// maximum length of the generated derivations (0 = no limit)
+		unsigned int MaxLength;
 		/// substitution rules
 		std::vector<SSubstitutionRule> SubstitutionRules;
+		/// index of the substitution rule of every symbol (-1 = no rule)
+		int RuleIndices[SYMBOL_COUNT];
 		/// the yaw angle
 		double AngleYaw;
 		/// the pitch angle
@@ -74,8 +167,85 @@ namespace DunGen
 		double RadiusFactor;
 		/// the radius decrement
 		double RadiusDecrement;
+
+		// memoized turtle transforms (computed on demand):
+
+		/// turtle transforms of all symbols without substitution
+		mutable std::vector<STurtleTransform> SymbolTransforms;
+		/// turtle transforms of the rule symbols after d+1 iterations: RuleTransforms[d][rule]
+		mutable std::vector<std::vector<STurtleTransform> > RuleTransforms;
+	};
+
+	/// lazy depth-first expansion of a derivation of an L-system
+	///
+	/// the symbols of the derivation are produced one by one, the derivation string is never stored:
+	/// a stack of cursors (one per derivation level) walks through the substitutions, so the memory is O(derivation).
+	/// Short expansions of the rule symbols (up to BlockSize symbols) are stored once as blocks and shared by all occurrences,
+	/// the cursors read them without descending further.
+	class CLSystemExpansion
+	{
+	public:
+		/// constructor: empty expansion
+		CLSystemExpansion();
+		/// constructor: expansion of the derivation derivation_ (0 = start) of the L-system
+		CLSystemExpansion(const CLSystem& lSystem_, unsigned int derivation_);
+
+		/// restart at the first symbol
+		void Reset();
+
+		/// get the next symbol without consuming it (0 at the end)
+		char Peek() const {return Symbol;}
+		/// get and consume the next symbol (0 at the end)
+		inline char Next();
+
+		/// test if both expansions produce the same derivation
+		bool operator==(const CLSystemExpansion& other_) const;
+
+	private:
+		/// moves to the next symbol of the derivation
+		void Advance();
+		/// computes the blocks of the short expansions of the rule symbols
+		void CreateBlocks();
+
+	private:
+		/// position in a string of a derivation level
+		struct SCursor
+		{
+			int Rule;				///< index of the substitution rule, -1 = start
+			int Block;				///< index of the block of the completely expanded substitution, -1 = no block
+			unsigned int Position;	///< position of the next symbol
+		};
+
+		/// maximum length of a block
+		static const unsigned int BlockSize = 1024;
+
+		/// start string (axiom)
+		std::string Start;
+		/// substitutions of the substitution rules
+		std::vector<std::string> RuleSubstitutions;
+		/// index of the substitution rule of every symbol (-1 = no rule)
+		int RuleIndices[CLSystem::SYMBOL_COUNT];
+		/// expanded derivation
+		unsigned int Derivation;
+		/// blocks: substitutions with their symbols expanded completely
+		std::vector<std::string> Blocks;
+		/// index of the block of every rule with n remaining expansions of its substitution: BlockIndices[n*rules + rule], -1 = too long
+		std::vector<int> BlockIndices;
+
+		/// cursors of the derivation levels (0 = start)
+		std::vector<SCursor> Cursors;
+		/// next symbol (0 at the end)
+		char Symbol;
 	};
 
+	char DunGen::CLSystemExpansion::Next()
+	{
+		const char symbol = Symbol;
+		if (symbol)
+			Advance();
+		return symbol;
+	}
+
 } // END NAMESPACE DunGen
 
 #endif
\ No newline at end of file
@@ -14,6 +14,10 @@
 // ======================================================
 void DunGen::CMeshCave::CreateMeshFromVoxels()
 {
+	// rebuild octree and buffers, if the dimensions of the voxel space have changed
+	if (DimX != VoxelCave->GetDimX() || DimY != VoxelCave->GetDimY() || DimZ != VoxelCave->GetDimZ())
+		BuildOctree();
+
 	// actualize the octree
 	ComputeOctree();
 
@@ -50,8 +54,8 @@ void DunGen::CMeshCave::ComputeOctree()
 			for (unsigned int k=actualOctreeNode->BorderMinY; k<=actualOctreeNode->BorderMaxY+1; ++k)
 				for (unsigned int l=actualOctreeNode->BorderMinZ; l<=actualOctreeNode->BorderMaxZ+1; ++l)
 				{
-					GlobalSweepPlane[actualSweepPlane1][k][l] = 0;
-					GlobalSweepPlane[actualSweepPlane2][k][l] = 0;
+					SweepPlane(actualSweepPlane1,k,l) = 0;
+					SweepPlane(actualSweepPlane2,k,l) = 0;
 				}
 			
 			// sweep along X-axis:
@@ -59,53 +63,64 @@ void DunGen::CMeshCave::ComputeOctree()
 			{
 				// YZ-plane is the sweep plane
 				for (unsigned int k=actualOctreeNode->BorderMinY; k<=actualOctreeNode->BorderMaxY; ++k)
-					for (unsigned int l=actualOctreeNode->BorderMinZ; l<=actualOctreeNode->BorderMaxZ; ++l)
+					for (unsigned int l=actualOctreeNode->BorderMinZ, rowEnd=0; l<=actualOctreeNode->BorderMaxZ; ++l)
 					{
+						// skip brick rows without junctions
+						if (l >= rowEnd)
+						{
+							rowEnd = VoxelCave->GetBrickRowEnd(l,actualOctreeNode->BorderMaxZ+1);
+							if (VoxelCave->IsRowWithoutJunction(j,k,l,rowEnd))
+							{
+								l = rowEnd-1;
+								continue;
+							}
+						}
+
 						// if actual voxel is 1 and neighbor voxel is 0 -> vertices needed
 						// (because a quad from 2 triangles will be created here later)
 						if (1 == VoxelCave->GetVoxel(j,k,l))
 						{
 							if (0 == VoxelCave->GetVoxel(j-1,k,l))
 							{
-								GlobalSweepPlane[actualSweepPlane1][k][l] = 1;
-								GlobalSweepPlane[actualSweepPlane1][k+1][l] = 1;
-								GlobalSweepPlane[actualSweepPlane1][k][l+1] = 1;
-								GlobalSweepPlane[actualSweepPlane1][k+1][l+1] = 1;
+								SweepPlane(actualSweepPlane1,k,l) = 1;
+								SweepPlane(actualSweepPlane1,k+1,l) = 1;
+								SweepPlane(actualSweepPlane1,k,l+1) = 1;
+								SweepPlane(actualSweepPlane1,k+1,l+1) = 1;
 							}
 							if (0 == VoxelCave->GetVoxel(j+1,k,l))
 							{
-								GlobalSweepPlane[actualSweepPlane2][k][l] = 1;
-								GlobalSweepPlane[actualSweepPlane2][k+1][l] = 1;
-								GlobalSweepPlane[actualSweepPlane2][k][l+1] = 1;
-								GlobalSweepPlane[actualSweepPlane2][k+1][l+1] = 1;
+								SweepPlane(actualSweepPlane2,k,l) = 1;
+								SweepPlane(actualSweepPlane2,k+1,l) = 1;
+								SweepPlane(actualSweepPlane2,k,l+1) = 1;
+								SweepPlane(actualSweepPlane2,k+1,l+1) = 1;
 							}
 							if (0 == VoxelCave->GetVoxel(j,k-1,l))
 							{
-								GlobalSweepPlane[actualSweepPlane1][k][l] = 1;
-								GlobalSweepPlane[actualSweepPlane1][k][l+1] = 1;
-								GlobalSweepPlane[actualSweepPlane2][k][l] = 1;
-								GlobalSweepPlane[actualSweepPlane2][k][l+1] = 1;
+								SweepPlane(actualSweepPlane1,k,l) = 1;
+								SweepPlane(actualSweepPlane1,k,l+1) = 1;
+								SweepPlane(actualSweepPlane2,k,l) = 1;
+								SweepPlane(actualSweepPlane2,k,l+1) = 1;
 							}
 							if (0 == VoxelCave->GetVoxel(j,k+1,l))
 							{
-								GlobalSweepPlane[actualSweepPlane1][k+1][l] = 1;
-								GlobalSweepPlane[actualSweepPlane1][k+1][l+1] = 1;
-								GlobalSweepPlane[actualSweepPlane2][k+1][l] = 1;
-								GlobalSweepPlane[actualSweepPlane2][k+1][l+1] = 1;
+								SweepPlane(actualSweepPlane1,k+1,l) = 1;
+								SweepPlane(actualSweepPlane1,k+1,l+1) = 1;
+								SweepPlane(actualSweepPlane2,k+1,l) = 1;
+								SweepPlane(actualSweepPlane2,k+1,l+1) = 1;
 							}
 							if (0 == VoxelCave->GetVoxel(j,k,l-1))
 							{
-								GlobalSweepPlane[actualSweepPlane1][k][l] = 1;
-								GlobalSweepPlane[actualSweepPlane1][k+1][l] = 1;
-								GlobalSweepPlane[actualSweepPlane2][k][l] = 1;
-								GlobalSweepPlane[actualSweepPlane2][k+1][l] = 1;
+								SweepPlane(actualSweepPlane1,k,l) = 1;
+								SweepPlane(actualSweepPlane1,k+1,l) = 1;
+								SweepPlane(actualSweepPlane2,k,l) = 1;
+								SweepPlane(actualSweepPlane2,k+1,l) = 1;
 							}
 							if (0 == VoxelCave->GetVoxel(j,k,l+1))
 							{
-								GlobalSweepPlane[actualSweepPlane1][k][l+1] = 1;
-								GlobalSweepPlane[actualSweepPlane1][k+1][l+1] = 1;
-								GlobalSweepPlane[actualSweepPlane2][k][l+1] = 1;
-								GlobalSweepPlane[actualSweepPlane2][k+1][l+1] = 1;
+								SweepPlane(actualSweepPlane1,k,l+1) = 1;
+								SweepPlane(actualSweepPlane1,k+1,l+1) = 1;
+								SweepPlane(actualSweepPlane2,k,l+1) = 1;
+								SweepPlane(actualSweepPlane2,k+1,l+1) = 1;
 							}
 						}
 					} // END: YZ-plane
@@ -114,8 +129,8 @@ void DunGen::CMeshCave::ComputeOctree()
 				for (unsigned int k=actualOctreeNode->BorderMinY; k<=actualOctreeNode->BorderMaxY+1; ++k)
 					for (unsigned int l=actualOctreeNode->BorderMinZ; l<=actualOctreeNode->BorderMaxZ+1; ++l)
 					{
-						actualOctreeNode->VertexNumber += GlobalSweepPlane[actualSweepPlane1][k][l];
-						GlobalSweepPlane[actualSweepPlane1][k][l] = 0;
+						actualOctreeNode->VertexNumber += SweepPlane(actualSweepPlane1,k,l);
+						SweepPlane(actualSweepPlane1,k,l) = 0;
 					}
 					
 				// swap sweep planes
@@ -128,7 +143,7 @@ void DunGen::CMeshCave::ComputeOctree()
 			// final increment
 			for (unsigned int k=actualOctreeNode->BorderMinY; k<=actualOctreeNode->BorderMaxY+1; ++k)
 				for (unsigned int l=actualOctreeNode->BorderMinZ; l<=actualOctreeNode->BorderMaxZ+1; ++l)
-					actualOctreeNode->VertexNumber += GlobalSweepPlane[actualSweepPlane1][k][l];
+					actualOctreeNode->VertexNumber += SweepPlane(actualSweepPlane1,k,l);
 
 		} // END: leaf check
 			
@@ -199,8 +214,8 @@ void DunGen::CMeshCave::ComputeGeometry()
 			for (unsigned int j=actualOctreeNode->BorderMinY; j<=actualOctreeNode->BorderMaxY+1; ++j)
 				for (unsigned int k=actualOctreeNode->BorderMinZ; k<=actualOctreeNode->BorderMaxZ+1; ++k)
 				{
-					GlobalSweepPlane[actualSweepPlane1][j][k] = MaxVertexCount+1;
-					GlobalSweepPlane[actualSweepPlane2][j][k] = MaxVertexCount+1;
+					SweepPlane(actualSweepPlane1,j,k) = MaxVertexCount+1;
+					SweepPlane(actualSweepPlane2,j,k) = MaxVertexCount+1;
 				}
 
 			// converting per sweep:
@@ -209,8 +224,19 @@ void DunGen::CMeshCave::ComputeGeometry()
 			{
 				// YZ-plane is the sweep plane
 				for (unsigned int j=actualOctreeNode->BorderMinY; j<=actualOctreeNode->BorderMaxY; ++j)
-					for (unsigned int k=actualOctreeNode->BorderMinZ; k<=actualOctreeNode->BorderMaxZ; ++k)
+					for (unsigned int k=actualOctreeNode->BorderMinZ, rowEnd=0; k<=actualOctreeNode->BorderMaxZ; ++k)
 					{
+						// skip brick rows without junctions
+						if (k >= rowEnd)
+						{
+							rowEnd = VoxelCave->GetBrickRowEnd(k,actualOctreeNode->BorderMaxZ+1);
+							if (VoxelCave->IsRowWithoutJunction(i,j,k,rowEnd))
+							{
+								k = rowEnd-1;
+								continue;
+							}
+						}
+
 						// if actual voxel is 1 and neighbor voxel is 0 -> creating triangles
 						if (1 == VoxelCave->GetVoxel(i,j,k))
 						{		
@@ -224,13 +250,13 @@ void DunGen::CMeshCave::ComputeGeometry()
 								CreateVertex(meshBuffer, bufferVertices, actualOctreeNode, actualSweepPlane1, i, j+1, k+1);
 
 								// add 2 triangles: order of the vertices is clockwise in the left-handed irrlicht coordinate system
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane1][j][k];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane1][j+1][k];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane1][j+1][k+1];
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane1,j,k);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane1,j+1,k);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane1,j+1,k+1);
 																
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane1][j][k];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane1][j+1][k+1];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane1][j][k+1];
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane1,j,k);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane1,j+1,k+1);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane1,j,k+1);
 							}
 
 							if (0 == VoxelCave->GetVoxel(i+1,j,k))
@@ -242,13 +268,13 @@ void DunGen::CMeshCave::ComputeGeometry()
 								CreateVertex(meshBuffer, bufferVertices, actualOctreeNode, actualSweepPlane2, i+1, j+1, k+1);
 			
 								// add 2 triangles: order of the vertices is clockwise in the left-handed irrlicht coordinate system
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane2][j][k];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane2][j+1][k+1];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane2][j+1][k];
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane2,j,k);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane2,j+1,k+1);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane2,j+1,k);
 								
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane2][j][k];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane2][j][k+1];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane2][j+1][k+1];
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane2,j,k);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane2,j,k+1);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane2,j+1,k+1);
 							}
 
 							// test along Y-axis
@@ -261,13 +287,13 @@ void DunGen::CMeshCave::ComputeGeometry()
 								CreateVertex(meshBuffer, bufferVertices, actualOctreeNode, actualSweepPlane2, i+1, j, k+1);
 
 								// add 2 triangles: order of the vertices is clockwise in the left-handed irrlicht coordinate system
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane1][j][k];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane1][j][k+1];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane2][j][k+1];
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane1,j,k);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane1,j,k+1);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane2,j,k+1);
 
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane1][j][k];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane2][j][k+1];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane2][j][k];
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane1,j,k);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane2,j,k+1);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane2,j,k);
 							}
 
 							if (0 == VoxelCave->GetVoxel(i,j+1,k))
@@ -279,13 +305,13 @@ void DunGen::CMeshCave::ComputeGeometry()
 								CreateVertex(meshBuffer, bufferVertices, actualOctreeNode, actualSweepPlane2, i+1, j+1, k+1);
 
 								// add 2 triangles: order of the vertices is clockwise in the left-handed irrlicht coordinate system
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane1][j+1][k];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane2][j+1][k+1];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane1][j+1][k+1];
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane1,j+1,k);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane2,j+1,k+1);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane1,j+1,k+1);
 
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane1][j+1][k];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane2][j+1][k];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane2][j+1][k+1];
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane1,j+1,k);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane2,j+1,k);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane2,j+1,k+1);
 							}
 
 							// test along Z-axis
@@ -298,13 +324,13 @@ void DunGen::CMeshCave::ComputeGeometry()
 								CreateVertex(meshBuffer, bufferVertices, actualOctreeNode, actualSweepPlane2, i+1, j+1, k);
 
 								// add 2 triangles: order of the vertices is clockwise in the left-handed irrlicht coordinate system
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane1][j][k];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane2][j+1][k];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane1][j+1][k];
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane1,j,k);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane2,j+1,k);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane1,j+1,k);
 
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane1][j][k];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane2][j][k];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane2][j+1][k];
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane1,j,k);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane2,j,k);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane2,j+1,k);
 							}
 
 							if (0 == VoxelCave->GetVoxel(i,j,k+1))
@@ -316,13 +342,13 @@ void DunGen::CMeshCave::ComputeGeometry()
 								CreateVertex(meshBuffer, bufferVertices, actualOctreeNode, actualSweepPlane2, i+1, j+1, k+1);
 							
 								// add 2 triangles: order of the vertices is clockwise in the left-handed irrlicht coordinate system
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane1][j][k+1];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane1][j+1][k+1];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane2][j+1][k+1];
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane1,j,k+1);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane1,j+1,k+1);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane2,j+1,k+1);
 								
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane1][j][k+1];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane2][j+1][k+1];
-								meshBuffer->Indices[bufferIndizes++] = GlobalSweepPlane[actualSweepPlane2][j][k+1];
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane1,j,k+1);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane2,j+1,k+1);
+								meshBuffer->Indices[bufferIndizes++] = SweepPlane(actualSweepPlane2,j,k+1);
 							}
 
 						} // END: if actual voxel is 1
@@ -332,7 +358,7 @@ void DunGen::CMeshCave::ComputeGeometry()
 				// reset used area of the sweep plane
 				for (unsigned int j=actualOctreeNode->BorderMinY; j<=actualOctreeNode->BorderMaxY+1; ++j)
 					for (unsigned int k=actualOctreeNode->BorderMinZ; k<=actualOctreeNode->BorderMaxZ+1; ++k)
-						GlobalSweepPlane[actualSweepPlane1][j][k] = MaxVertexCount+1;
+						SweepPlane(actualSweepPlane1,j,k) = MaxVertexCount+1;
 					
 				// swap sweep planes
 				tempInt = actualSweepPlane1;
@@ -460,10 +486,10 @@ void DunGen::CMeshCave::ComputeNormals()
 				hashX = d2i(tempVec.X);
 				hashZ = d2i(tempVec.Z);
 
-				if (NULL == HashTable[hashX][hashZ])
-					HashTable[hashX][hashZ] = new std::list<SVertexInformations>();
+				if (NULL == HashTableEntry(hashX,hashZ))
+					HashTableEntry(hashX,hashZ) = new std::list<SVertexInformations>();
 
-				HashTable[hashX][hashZ]->push_front(newVertexInfo);
+				HashTableEntry(hashX,hashZ)->push_front(newVertexInfo);
 			}
 	}
 
@@ -473,19 +499,19 @@ void DunGen::CMeshCave::ComputeNormals()
 	SVertexAddress actualVertexAdress;
 
 	// process hash table
-	for (unsigned int i=0; i<SVoxelSpace::DimX+1; ++i)
-		for (unsigned int j=0; j<SVoxelSpace::DimY+1; ++j)
-			if (NULL != HashTable[i][j])
+	for (unsigned int i=0; i<DimX+1; ++i)
+		for (unsigned int j=0; j<DimZ+1; ++j)
+			if (NULL != HashTableEntry(i,j))
 			{
 				// sort table by Y
-				HashTable[i][j]->sort();
+				HashTableEntry(i,j)->sort();
 
 				// combine table entries
-				actualY = HashTable[i][j]->front().Y;
+				actualY = HashTableEntry(i,j)->front().Y;
 				normal = irr::core::vector3d<double>(0.0,0.0,0.0);
 				
 				// walk over all entries
-				for (std::list<SVertexInformations>::iterator it=HashTable[i][j]->begin() ; it != HashTable[i][j]->end(); ++it)
+				for (std::list<SVertexInformations>::iterator it=HashTableEntry(i,j)->begin() ; it != HashTableEntry(i,j)->end(); ++it)
 				{
 					// if new vertex -> store old normal
 					if (actualY!=(*it).Y)
@@ -519,8 +545,8 @@ void DunGen::CMeshCave::ComputeNormals()
 				}
 
 				// delete hash entries, because they are processed
-				delete HashTable[i][j];
-				HashTable[i][j] = NULL;
+				delete HashTableEntry(i,j);
+				HashTableEntry(i,j) = NULL;
 			}
 
 	// ~~~~~~~~~~~~~~~~~~~~~
@@ -543,11 +569,11 @@ inline void DunGen::CMeshCave::CreateVertex(irr::scene::SMeshBuffer* meshBuffer_
 	unsigned int sweepPlaneLayer_, unsigned int x_, unsigned int y_, unsigned int z_)
 {
 	// test if no vertex is present already
-	if (GlobalSweepPlane[sweepPlaneLayer_][y_][z_] > MaxVertexCount)
+	if (SweepPlane(sweepPlaneLayer_,y_,z_) > MaxVertexCount)
 	{	
 		// create new vertex
 		irr::video::S3DVertex& v = meshBuffer_->Vertices[bufferVertices_];
-		GlobalSweepPlane[sweepPlaneLayer_][y_][z_] = bufferVertices_++;
+		SweepPlane(sweepPlaneLayer_,y_,z_) = bufferVertices_++;
 
 		// marking will be computed by ComputeVertexCoordinates() and saved as texture coordinate Y
 		irr::f32 markingDockingVertex;
@@ -563,14 +589,30 @@ inline void DunGen::CMeshCave::CreateVertex(irr::scene::SMeshBuffer* meshBuffer_
 
 irr::core::vector3d<irr::f32> DunGen::CMeshCave::ComputeVertexCoordinates(unsigned int x_, unsigned int y_, unsigned int z_, irr::f32& markingDockingVertex_)
 {
+	// distance field available: the vertex is placed onto the surface, no warping needed
+	if (VoxelCave->HasDistanceField())
+		return ComputeVertexCoordinatesFromDistances(x_,y_,z_,markingDockingVertex_);
+
 	// no warping: grid coordinates are used
 	if (!WarpEnabled)
 		return irr::core::vector3d<irr::f32>(static_cast<irr::f32>(x_),static_cast<irr::f32>(y_),static_cast<irr::f32>(z_));
 
-	// set random seed based on coordinates, try to avoid symmetry
+	// random numbers for the 3 directions based on the coordinates
 	// important: process has to be deterministic
 	// (the coordinates of bordervertices have to be identical for all affected meshbuffers)
-	RandomGenerator->SetSeed(RandomSeed + x_ + (SVoxelSpace::DimX+1)*y_ + (SVoxelSpace::DimX+1)*(SVoxelSpace::DimY+1)*z_); 
+	double random[3];
+	if (RandomGenerator->IsLegacyMode())
+	{
+		// set random seed based on coordinates, try to avoid symmetry
+		RandomGenerator->SetSeed(RandomSeed + x_ + (VoxelCave->GetDimX()+1)*y_ + (VoxelCave->GetDimX()+1)*(VoxelCave->GetDimY()+1)*z_); 
+		for (unsigned int i=0; i<3; ++i)
+			random[i] = RandomGenerator->GetRandomNumber01();
+	}
+	else
+	{
+		for (unsigned int i=0; i<3; ++i)
+			random[i] = RandomGenerator->GetHashNumber01(RandomSeed, x_, y_, z_, i);
+	}
 	double deltaX, deltaY, deltaZ;
 
 	// if a 6-connected voxel is marked with 3 (dockingvoxel), this is a dockingvertex
@@ -594,34 +636,34 @@ irr::core::vector3d<irr::f32> DunGen::CMeshCave::ComputeVertexCoordinates(unsign
 		// warp with the appropriate warp strenght and direction
 		// X-direction
 		if (0 == warpDirections.DirectionX)
-			deltaX = -WarpStrength + 2*WarpStrength * RandomGenerator->GetRandomNumber01();
+			deltaX = -WarpStrength + 2*WarpStrength * random[0];
 		else if (warpDirections.DirectionX > 0)
-			deltaX = WarpStrength * RandomGenerator->GetRandomNumber01();
+			deltaX = WarpStrength * random[0];
 		else
-			deltaX = -WarpStrength * RandomGenerator->GetRandomNumber01();
+			deltaX = -WarpStrength * random[0];
 
 		// Y-direction
 		if (0 == warpDirections.DirectionY)
-			deltaY = -WarpStrength + 2*WarpStrength * RandomGenerator->GetRandomNumber01();
+			deltaY = -WarpStrength + 2*WarpStrength * random[1];
 		else if (warpDirections.DirectionY > 0)
-			deltaY = WarpStrength * RandomGenerator->GetRandomNumber01();
+			deltaY = WarpStrength * random[1];
 		else
-			deltaY = -WarpStrength * RandomGenerator->GetRandomNumber01();
+			deltaY = -WarpStrength * random[1];
 
 		// Z-direction
 		if (0 == warpDirections.DirectionZ)
-			deltaZ = -WarpStrength + 2*WarpStrength * RandomGenerator->GetRandomNumber01();
+			deltaZ = -WarpStrength + 2*WarpStrength * random[2];
 		else if (warpDirections.DirectionZ > 0)
-			deltaZ = WarpStrength * RandomGenerator->GetRandomNumber01();
+			deltaZ = WarpStrength * random[2];
 		else
-			deltaZ = -WarpStrength * RandomGenerator->GetRandomNumber01();
+			deltaZ = -WarpStrength * random[2];
 	}
 	else // warping without smoothing
 	{
 		// warping in the interval between -WarpStrength and +WarpStrength
-		deltaX = -WarpStrength + 2*WarpStrength * RandomGenerator->GetRandomNumber01();
-		deltaY = -WarpStrength + 2*WarpStrength * RandomGenerator->GetRandomNumber01();
-		deltaZ = -WarpStrength + 2*WarpStrength * RandomGenerator->GetRandomNumber01();
+		deltaX = -WarpStrength + 2*WarpStrength * random[0];
+		deltaY = -WarpStrength + 2*WarpStrength * random[1];
+		deltaZ = -WarpStrength + 2*WarpStrength * random[2];
 	}
 
 	// clamping to adjust positioning to prevent intersecting triangles
@@ -717,6 +759,78 @@ irr::core::vector3d<irr::f32> DunGen::CMeshCave::ComputeVertexCoordinates(unsign
 	return result;
 }
 
+irr::core::vector3d<irr::f32> DunGen::CMeshCave::ComputeVertexCoordinatesFromDistances(unsigned int x_, unsigned int y_, unsigned int z_, irr::f32& markingDockingVertex_)
+{
+	// vertex is shared by voxel[X-1,Y-1,Z-1] to voxel[X,Y,Z], the voxel centers lie at +-0.5 around the vertex
+	unsigned char values[8];
+	int distances[8];
+	bool dockingVertex = false;
+	for (unsigned int i=0; i<8; ++i)
+	{
+		const unsigned int x = x_-1+(i&1);
+		const unsigned int y = y_-1+((i>>1)&1);
+		const unsigned int z = z_-1+((i>>2)&1);
+		values[i] = VoxelCave->GetVoxel(x,y,z);
+		distances[i] = VoxelCave->GetDistance(x,y,z);
+		dockingVertex |= (CVoxelCave::DockingVoxel == values[i]);
+	}
+
+	irr::core::vector3d<irr::f32> result(static_cast<irr::f32>(x_),static_cast<irr::f32>(y_),static_cast<irr::f32>(z_));
+
+	// dockingvertices stay on the grid
+	markingDockingVertex_ = dockingVertex ? 1.0f : -1.0f;
+	if (dockingVertex)
+		return result;
+
+	// average of the surface crossings on the 12 edges between the voxel centers (surface nets)
+	irr::core::vector3d<irr::f32> sum(0.0f,0.0f,0.0f);
+	unsigned int crossings = 0;
+	for (unsigned int axis=0; axis<3; ++axis)
+	{
+		const unsigned int step = 1<<axis;
+		for (unsigned int i=0; i<8; ++i)
+		{
+			if (i & step)
+				continue;
+			const unsigned int j = i|step;
+
+			// surface crosses the edge, if the occupancy changes
+			const bool freeI = 0 != (values[i]&1);
+			const bool freeJ = 0 != (values[j]&1);
+			if (freeI == freeJ)
+				continue;
+
+			// interpolate between the free (distance >= 0) and the stone (distance < 0) voxel,
+			// fall back to the middle, if the distances do not match the occupancy (eroded or filtered voxels)
+			const int distanceFree = freeI ? distances[i] : distances[j];
+			const int distanceStone = freeI ? distances[j] : distances[i];
+			irr::f32 t = 0.5f;
+			if (distanceFree >= 0 && distanceStone < 0)
+				t = static_cast<irr::f32>(distanceFree) / static_cast<irr::f32>(distanceFree-distanceStone);
+			if (!freeI)
+				t = 1.0f-t;
+
+			irr::core::vector3d<irr::f32> crossing(
+				static_cast<irr::f32>(i&1) - 0.5f,
+				static_cast<irr::f32>((i>>1)&1) - 0.5f,
+				static_cast<irr::f32>((i>>2)&1) - 0.5f);
+			if (0 == axis)
+				crossing.X += t;
+			else if (1 == axis)
+				crossing.Y += t;
+			else
+				crossing.Z += t;
+			sum += crossing;
+			++crossings;
+		}
+	}
+
+	if (crossings > 0)
+		result += sum / static_cast<irr::f32>(crossings);
+
+	return result;
+}
+
 irr::f32 DunGen::CMeshCave::IsBorderVertex(unsigned int x_, unsigned int y_, unsigned int z_, SOctreeNode* octreeNode_)
 {
 	// vertex is shared by voxel[X-1,Y-1,Z-1] to voxel[X,Y,Z] (8 voxel total)
@@ -95,6 +95,9 @@ namespace DunGen
 		void SetPrintToConsole(bool enabled_);
 
 	private:
+		/// build the octree and the buffers for the dimensions of the voxel space
+		void BuildOctree();
+
 		/// compute the octree of the voxelspace
 		void ComputeOctree();
 
@@ -108,9 +111,18 @@ namespace DunGen
 		inline void CreateVertex(irr::scene::SMeshBuffer* meshBuffer_, unsigned int& bufferVertices_, SOctreeNode* octreeNode_,
 			unsigned int sweepPlaneLayer_, unsigned int x_, unsigned int y_, unsigned int z_);
 
+		/// computes vertex coordinates from the distance field of the voxel cave (surface nets) and if the vertex is a docking vertex
+		irr::core::vector3d<irr::f32> ComputeVertexCoordinatesFromDistances(unsigned int x_, unsigned int y_, unsigned int z_, irr::f32& markingDockingVertex_);
+
 		/// tests if a vertex is a border vertex (which is shared by other mesh buffers)
 		irr::f32 IsBorderVertex(unsigned int x_, unsigned int y_, unsigned int z_, SOctreeNode* octreeNode_);
 
+		/// access to the global sweep plane
+		inline unsigned int& SweepPlane(unsigned int layer_, unsigned int y_, unsigned int z_);
+
+		/// access to the hash table
+		inline std::list<SVertexInformations>*& HashTableEntry(unsigned int x_, unsigned int z_);
+
 	private:
 		/// the stored mesh
 		irr::scene::SMesh* Mesh;
@@ -137,11 +149,14 @@ namespace DunGen
 		/// maximal number of vertices per meshbuffer
 		static const unsigned int MaxVertexCount = 65500;
 
-		/// global sweep plane, for counting and referring vertices
-		unsigned int GlobalSweepPlane[2][SVoxelSpace::DimY+1][SVoxelSpace::DimZ+1];
+		/// dimensions of the voxel space, the octree and the buffers are built for
+		unsigned int DimX, DimY, DimZ;
+
+		/// global sweep plane, for counting and referring vertices: 2 layers of (DimY+1)*(DimZ+1)
+		std::vector<unsigned int> GlobalSweepPlane;
 
-		/// hash table for normal computing: hash value = (X,Z) rounded in integer values
-		std::list<SVertexInformations>* HashTable[SVoxelSpace::DimX+1][SVoxelSpace::DimZ+1];
+		/// hash table for normal computing: hash value = (X,Z) rounded in integer values, (DimX+1)*(DimZ+1) entries
+		std::vector<std::list<SVertexInformations>*> HashTable;
 		
 		/// look up table for allowed warp directions
 		SVertexWarpDirections VertexWarpDirections[256];
@@ -153,6 +168,16 @@ namespace DunGen
 		bool PrintToConsole;
 	};
 
+	unsigned int& DunGen::CMeshCave::SweepPlane(unsigned int layer_, unsigned int y_, unsigned int z_)
+	{
+		return GlobalSweepPlane[(layer_*(DimY+1) + y_)*(DimZ+1) + z_];
+	}
+
+	std::list<DunGen::CMeshCave::SVertexInformations>*& DunGen::CMeshCave::HashTableEntry(unsigned int x_, unsigned int z_)
+	{
+		return HashTable[x_*(DimZ+1) + z_];
+	}
+
 } // END NAMESPACE DunGen
 
 #endif
\ No newline at end of file
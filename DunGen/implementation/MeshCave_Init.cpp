@@ -3,6 +3,7 @@
 // For conditions of distribution and use, see licence.txt provided together with DunGen.
 
 #include "MeshCave.h"
+#include "VoxelCave.h"
 
 // ======================================================
 // structs
@@ -89,17 +90,13 @@ __declspec(noinline) DunGen::CMeshCave::CMeshCave(CVoxelCave* voxelCave_, const
 	, SmoothEnabled(true)
 	, WarpStrength(0.35)
 	, NormalWeightMethod(ENormalWeightMethod::BY_AREA)
+	, DimX(0), DimY(0), DimZ(0)
 	, PrintToConsole(false)
 {
 	// create empty mesh
 	Mesh = new irr::scene::SMesh();
 	Mesh->recalculateBoundingBox();
 
-	// initialize hashtable
-	for (unsigned int i=0; i<SVoxelSpace::DimX+1; ++i)
-		for (unsigned int j=0; j<SVoxelSpace::DimY+1; ++j)
-			HashTable[i][j] = NULL;
-
 	// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 	// init lookup table for warp directions:
 	// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -212,6 +209,27 @@ __declspec(noinline) DunGen::CMeshCave::CMeshCave(CVoxelCave* voxelCave_, const
 
 	} // ENDE: initialization lookup table for warp directions
 
+	// precompute octree
+	BuildOctree();
+
+} // END: constructor
+
+void DunGen::CMeshCave::BuildOctree()
+{
+	// delete old octree nodes
+	for (unsigned int i=0; i<Octree.size(); ++i)
+		delete Octree[i];
+	Octree.clear();
+
+	// take over the dimensions of the voxel space
+	DimX = VoxelCave->GetDimX();
+	DimY = VoxelCave->GetDimY();
+	DimZ = VoxelCave->GetDimZ();
+
+	// size sweep plane and hashtable accordingly
+	GlobalSweepPlane.assign(2*(DimY+1)*(DimZ+1), 0);
+	HashTable.assign((DimX+1)*(DimZ+1), static_cast<std::list<SVertexInformations>*>(NULL));
+
 	// ~~~~~~~~~~~~~~~~~~
 	// precompute octree:
 	// ~~~~~~~~~~~~~~~~~~
@@ -223,9 +241,9 @@ __declspec(noinline) DunGen::CMeshCave::CMeshCave(CVoxelCave* voxelCave_, const
 	actualOctreeNode->BorderMinX = SVoxelSpace::MinBorder;
 	actualOctreeNode->BorderMinY = SVoxelSpace::MinBorder;
 	actualOctreeNode->BorderMinZ = SVoxelSpace::MinBorder;
-	actualOctreeNode->BorderMaxX = SVoxelSpace::DimX - SVoxelSpace::MinBorder - 1;
-	actualOctreeNode->BorderMaxY = SVoxelSpace::DimY - SVoxelSpace::MinBorder - 1;
-	actualOctreeNode->BorderMaxZ = SVoxelSpace::DimZ - SVoxelSpace::MinBorder - 1;
+	actualOctreeNode->BorderMaxX = DimX - SVoxelSpace::MinBorder - 1;
+	actualOctreeNode->BorderMaxY = DimY - SVoxelSpace::MinBorder - 1;
+	actualOctreeNode->BorderMaxZ = DimZ - SVoxelSpace::MinBorder - 1;
 	for (unsigned int i=0; i<8; ++i)
 		actualOctreeNode->ChildNode[i] = NULL;
 	actualOctreeNode->ParentNode = NULL;
@@ -244,8 +262,8 @@ __declspec(noinline) DunGen::CMeshCave::CMeshCave(CVoxelCave* voxelCave_, const
 		// if size too large: split up
 		if (
 		((actualOctreeNode->BorderMaxX-actualOctreeNode->BorderMinX+1)*
-		(actualOctreeNode->BorderMaxX-actualOctreeNode->BorderMinX+1)*
-		(actualOctreeNode->BorderMaxX-actualOctreeNode->BorderMinX+1)) > MaxVertexCount)
+		(actualOctreeNode->BorderMaxY-actualOctreeNode->BorderMinY+1)*
+		(actualOctreeNode->BorderMaxZ-actualOctreeNode->BorderMinZ+1)) > MaxVertexCount)
 		{
 			// compute borders for splitting
 			borderX = actualOctreeNode->BorderMinX+(actualOctreeNode->BorderMaxX-actualOctreeNode->BorderMinX)/2;
@@ -334,8 +352,7 @@ __declspec(noinline) DunGen::CMeshCave::CMeshCave(CVoxelCave* voxelCave_, const
 		// next node
 		++actualNodeID;
 	}
-
-} // END: constructor
+}
 
 
 DunGen::CMeshCave::~CMeshCave()
@@ -8,8 +8,12 @@
 // Namespace DunGen : DungeonGenerator
 namespace DunGen
 {
-	/// random number generator: linear congruential generator
+	/// random number generator: stateless hash generator or linear congruential generator (legacy mode)
 	///
+	/// the hash generator computes every number from a seed, coordinates and a stream number: value = f(seed,x,y,z,stream),
+	/// so the numbers do not depend on the order of the requests (and can be requested by several threads at once)
+	///
+	/// the linear congruential generator is used in legacy mode (reproduces the random number sequence of older versions),
 	/// as described by Knuth, The Art of Computer Programming, Volume 2: Seminumerical Algorithms
 	/// X[i+1] = (a*X[i]+c) mod m
 	class CRandomGenerator
@@ -23,6 +27,8 @@ namespace DunGen
 			SetA(1103515245);
 			SetC(12345);
 			SetM(32768);
+			SetHashSeed(0);
+			SetLegacyMode(false);
 		}
 		/// destructor
 		~CRandomGenerator()
@@ -59,6 +65,18 @@ namespace DunGen
 			X = seed_;
 		}
 
+		/// set the seed of the hash generator
+		void SetHashSeed(unsigned int seed_)
+		{
+			HashSeed = seed_;
+		}
+
+		/// set legacy mode: the users of the generator draw sequential numbers from the linear congruential generator
+		void SetLegacyMode(bool legacyMode_)
+		{
+			LegacyMode = legacyMode_;
+		}
+
 		/// read parameter A
 		unsigned int GetA() const
 		{
@@ -77,6 +95,18 @@ namespace DunGen
 			return M;
 		}
 
+		/// read the seed of the hash generator
+		unsigned int GetHashSeed() const
+		{
+			return HashSeed;
+		}
+
+		/// read legacy mode
+		bool IsLegacyMode() const
+		{
+			return LegacyMode;
+		}
+
 		// ==================================
 		// random number generation functions
 		// ==================================
@@ -115,6 +145,34 @@ namespace DunGen
 			return static_cast<double>(RandomNumber()+1) / MaxValuePlus1;
 		}
 
+		// ==================================
+		// stateless hash functions
+		// ==================================
+
+		/// returns random integer between 0 and 2^32-1 for the seed and the coordinates
+		unsigned int GetHashNumber(unsigned int seed_, unsigned int x_, unsigned int y_, unsigned int z_, unsigned int stream_) const
+		{
+			return HashNumber(seed_,x_,y_,z_,stream_);
+		}
+
+		/// returns random integer in [_Minimum,_Maximum] for the seed and the coordinates
+		int GetHashNumberMinMax(int minimum_, int maximum_, unsigned int seed_, unsigned int x_, unsigned int y_, unsigned int z_, unsigned int stream_) const
+		{
+			return static_cast<int>(HashNumber(seed_,x_,y_,z_,stream_) % static_cast<unsigned int>(maximum_-minimum_+1)) + minimum_;
+		}
+
+		/// returns random double in [0,1] for the seed and the coordinates
+		double GetHashNumber01(unsigned int seed_, unsigned int x_, unsigned int y_, unsigned int z_, unsigned int stream_) const
+		{
+			return static_cast<double>(HashNumber(seed_,x_,y_,z_,stream_)) / 4294967295.0;
+		}
+
+		/// returns random double in (0,1] for the seed and the coordinates
+		double GetHashNumber_01(unsigned int seed_, unsigned int x_, unsigned int y_, unsigned int z_, unsigned int stream_) const
+		{
+			return (static_cast<double>(HashNumber(seed_,x_,y_,z_,stream_)) + 1.0) / 4294967296.0;
+		}
+
 	private:
 		
 		/// core random function
@@ -123,6 +181,27 @@ namespace DunGen
 			X = (A * X + C) % M;
 			return X;
 		}
+
+		/// core hash function: the arguments are mixed in one after another
+		inline unsigned int HashNumber(unsigned int seed_, unsigned int x_, unsigned int y_, unsigned int z_, unsigned int stream_) const
+		{
+			unsigned int h = Mix(seed_ ^ 0x9e3779b9u);
+			h = Mix(h ^ x_);
+			h = Mix(h ^ y_);
+			h = Mix(h ^ z_);
+			return Mix(h ^ stream_);
+		}
+
+		/// bijective mixing of the bits (finalizer of MurmurHash3)
+		static inline unsigned int Mix(unsigned int h_)
+		{
+			h_ ^= h_ >> 16;
+			h_ *= 0x85ebca6bu;
+			h_ ^= h_ >> 13;
+			h_ *= 0xc2b2ae35u;
+			h_ ^= h_ >> 16;
+			return h_;
+		}
 		
 		/// parameter A
 		unsigned int A;
@@ -142,6 +221,12 @@ namespace DunGen
 		/// pre conversion to double: maximum value + 1
 		double MaxValuePlus1;
 
+		/// seed of the hash generator
+		unsigned int HashSeed;
+
+		/// legacy mode: linear congruential generator instead of hash generator
+		bool LegacyMode;
+
 	};
 
 } // END NAMESPACE DunGen
@@ -5,24 +5,42 @@
 #include "VoxelCave.h"
 #include "Helperfunctions.h"
 #include "RandomGenerator.h"
+#include <algorithm>
+#include <float.h>
+#include <functional>
 #include <iostream>
+#include <limits.h>
 #include <math.h>
 #include <queue>
-#include <stack>
 
 // ======================================================
 // constructor / destructor
 // ======================================================
 
-// no inlining (else the VS compiler tends to put the whole pre-initialized voxelspace in the executable in some cases)
-__declspec(noinline) DunGen::CVoxelCave::CVoxelCave(const CRandomGenerator* randomGenerator_)
-	: RandomGenerator(randomGenerator_)
+DunGen::CVoxelCave::CVoxelCave(const CRandomGenerator* randomGenerator_)
+	: VoxelSpace(SVoxelSpace::DefaultDimX, SVoxelSpace::DefaultDimY, SVoxelSpace::DefaultDimZ)
+	, Classifier(VoxelSpace)
+	, TurtleMaxReductions(0)
+	, TurtleAngleYaw(0.0), TurtleAnglePitch(0.0), TurtleAngleRoll(0.0)
+	, TurtleSegmentsValid(false)
+	, TurtlePeakDepth(0)
+	, RandomGenerator(randomGenerator_)
 	, Border(SVoxelSpace::MinBorder)
 	, MinDrawRadius(2)
 	, PrintToConsole(false)
+	, DistanceFieldEnabled(false)
+	, DistanceFieldValid(false)
+	, FilterMode(EFilterMode::OUTER_HULL)
+	, FilterPeakFrontier(0)
+	, ErosionCount(0)
+	, JunctionCount(0)
 {
-	// clear voxelspace
-	memset(Voxel,0,sizeof(unsigned char)*SVoxelSpace::DimX*SVoxelSpace::DimY*SVoxelSpace::DimZ);
+	// the constructor of the voxel space sets up its brick table: all bricks are uniform 0, no voxel storage is allocated
+
+	// symbols without meaning for the turtle (0 is the end of the derivation)
+	const std::string turtleSymbols = "F![]+-uozg|$";
+	for (unsigned int i=0; i<CLSystem::SYMBOL_COUNT; ++i)
+		TurtleIgnoredSymbols[i] = (0 != i && std::string::npos == turtleSymbols.find(static_cast<char>(i)));
 }
 
 DunGen::CVoxelCave::~CVoxelCave()
@@ -38,6 +56,19 @@ void DunGen::CVoxelCave::SetBorder(unsigned int border_)
 	Border = (border_ >= SVoxelSpace::MinBorder) ? border_ : SVoxelSpace::MinBorder;
 }
 
+void DunGen::CVoxelCave::SetDimensions(unsigned int dimX_, unsigned int dimY_, unsigned int dimZ_)
+{
+	// clamp to the allowed range
+	dimX_ = (dimX_ < SVoxelSpace::MinDim) ? SVoxelSpace::MinDim : ((dimX_ > SVoxelSpace::MaxDim) ? SVoxelSpace::MaxDim : dimX_);
+	dimY_ = (dimY_ < SVoxelSpace::MinDim) ? SVoxelSpace::MinDim : ((dimY_ > SVoxelSpace::MaxDim) ? SVoxelSpace::MaxDim : dimY_);
+	dimZ_ = (dimZ_ < SVoxelSpace::MinDim) ? SVoxelSpace::MinDim : ((dimZ_ > SVoxelSpace::MaxDim) ? SVoxelSpace::MaxDim : dimZ_);
+
+	VoxelSpace.SetDimensions(dimX_, dimY_, dimZ_);
+
+	// the junctions are counted again for the new brick layout
+	BrickJunctions.clear();
+}
+
 void DunGen::CVoxelCave::SetMinDrawRadius(unsigned int minDrawRadius_)
 {
 	MinDrawRadius = minDrawRadius_;
@@ -48,331 +79,461 @@ void DunGen::CVoxelCave::SetPrintToConsole(bool enabled_)
 	PrintToConsole = enabled_;
 }
 
-// ======================================================
-// setting voxels
-// ======================================================
-
-inline void DunGen::CVoxelCave::DrawVoxelBlock(unsigned int x_,unsigned int y_,unsigned int z_)
+void DunGen::CVoxelCave::SetDistanceFieldEnabled(bool enabled_)
 {
-	// draw block of voxels around a central voxel
-
-	// draw central voxel
-	SetVoxel(x_,y_,z_,1);
-	
-	// draw 6-connected voxels
-	SetVoxel(x_-1,y_,z_,1); SetVoxel(x_,y_-1,z_,1); SetVoxel(x_,y_,z_-1,1);	
-	SetVoxel(x_+1,y_,z_,1); SetVoxel(x_,y_+1,z_,1); SetVoxel(x_,y_,z_+1,1);
-
-	// draw 18-connected voxels
-	SetVoxel(x_-1,y_-1,z_,1); SetVoxel(x_-1,y_+1,z_,1); SetVoxel(x_+1,y_-1,z_,1); SetVoxel(x_+1,y_+1,z_,1);
-	SetVoxel(x_-1,y_,z_-1,1); SetVoxel(x_-1,y_,z_+1,1); SetVoxel(x_+1,y_,z_-1,1); SetVoxel(x_+1,y_,z_+1,1);
-	SetVoxel(x_,y_-1,z_-1,1); SetVoxel(x_,y_-1,z_+1,1); SetVoxel(x_,y_+1,z_-1,1); SetVoxel(x_,y_+1,z_+1,1);	
+	DistanceFieldEnabled = enabled_;
 }
 
-inline void DunGen::CVoxelCave::DrawVoxelToVector(int x_, int y_, int z_, std::vector<SVoxelToDraw>& vector_)
+void DunGen::CVoxelCave::SetFilterMode(EFilterMode::Enum filterMode_)
 {
-	// create voxel
-	SVoxelToDraw newVoxel;
-	newVoxel.X = x_;
-	newVoxel.Y = y_;
-	newVoxel.Z = z_;
-	// store voxel in the vector
-	vector_.push_back(newVoxel);
+	FilterMode = filterMode_;
 }
 
 // ======================================================
-// Bresenham in 3D
+// drawing functions for geometric primitives
 // ======================================================
-// 3D extension of Bresenhams algorithm
-// source:
-//    Three-dimensional extension of Bresenham's algorithm and its application in straight-line interpolation,
-//    Proceedings of the Institution of Mechanical Engineers, Part B: Journal of Engineering Manufacture March 1, 2002 216: 459-463
-//    pib.sagepub.com/content/216/3/459.full.pdf
-// modificated for all possible cases
-
-inline void DunGen::CVoxelCave::Bresenham3dX(int xs_,int ys_,int zs_,int xe_,int ye_,int ze_, std::vector<SVoxelToDraw>& vector_)
-{	// input: endpoints
-	
-	// compute directions
-	int xinc = (xe_<xs_) ? -1 : 1;
-	int yinc = (ye_<ys_) ? -1 : 1;
-	int zinc = (ze_<zs_) ? -1 : 1;
-
-	// compute dx,dy,dz
-	int dx=abs (xe_-xs_);
-	int dy=abs (ye_-ys_);
-	int dz=abs (ze_-zs_);
-
-	// compute initial decision parameters
-	int ey=2*dy-dx; int ez=2*dz-dx;
-	// compute constants for Y
-	int twoDy=2*dy; int twoDyDx=2*(dy-dx);
-	// compute constants for Z
-	int twoDz=2*dz; int twoDzDx=2*(dz-dx);
-	// inialize position
-	int x=xs_; int y=ys_; int z=zs_;
-	
-	// loop to draw the line
-	for (int i=0; i<=dx; ++i)
-	{
-		// draw voxel
-		DrawVoxelToVector(x,y,z,vector_);
 
-		// start of computing the next position
-		x+=xinc; 
-		if (ey>=0) {
-			y+=yinc; ey+=twoDyDx;
-		}
-		else
-			ey+=twoDy;
-		
-		if (ez>=0) {
-			z+=zinc; ez+=twoDzDx;
+bool DunGen::CVoxelCave::GetCapsuleSpan(int x_, int y_, int xs_,int ys_,int zs_,int xe_,int ye_,int ze_, int radius_, int& zBegin_, int& zEnd_)
+{
+	// the capsule contains all voxels with a distance of at most radius_ to the segment (start,end):
+	// a cylinder around the segment, closed by a sphere at both ends
+	// the intersection of a row with the (convex) capsule is a single span
+	zBegin_ = INT_MAX;
+	zEnd_ = INT_MIN;
+
+	// the end caps use the exact span tables of the spheres
+	const std::vector<int>& spans = GetSphereSpans(radius_);
+
+	// start cap
+	if (abs(x_-xs_) <= radius_ && abs(y_-ys_) <= radius_)
+	{
+		const int halfLength = spans[abs(x_-xs_)*(radius_+1)+abs(y_-ys_)];
+		if (halfLength >= 0)
+		{
+			zBegin_ = std::min(zBegin_, zs_-halfLength);
+			zEnd_ = std::max(zEnd_, zs_+halfLength);
 		}
-		else
-			ez+=twoDz;
-		// end of computing the next position
 	}
-}
 
-inline void DunGen::CVoxelCave::Bresenham3dY(int xs_,int ys_,int zs_,int xe_,int ye_,int ze_, std::vector<SVoxelToDraw>& vector_)
-{	// input: endpoints
-
-	// compute directions
-	int xinc = (xe_<xs_) ? -1 : 1;
-	int yinc = (ye_<ys_) ? -1 : 1;
-	int zinc = (ze_<zs_) ? -1 : 1;
+	// end cap
+	if (abs(x_-xe_) <= radius_ && abs(y_-ye_) <= radius_)
+	{
+		const int halfLength = spans[abs(x_-xe_)*(radius_+1)+abs(y_-ye_)];
+		if (halfLength >= 0)
+		{
+			zBegin_ = std::min(zBegin_, ze_-halfLength);
+			zEnd_ = std::max(zEnd_, ze_+halfLength);
+		}
+	}
 
-	// compute dx,dy,dz
-	int dx=abs (xe_-xs_);
-	int dy=abs (ye_-ys_);
-	int dz=abs (ze_-zs_);
+	// segment direction
+	const double dx = static_cast<double>(xe_-xs_);
+	const double dy = static_cast<double>(ye_-ys_);
+	const double dz = static_cast<double>(ze_-zs_);
+	const double lengthSquared = dx*dx + dy*dy + dz*dz;
 
-	// compute initial decision parameters
-	int ex=2*dx-dy; int ez=2*dz-dy;
-	// compute constants for X
-	int twoDx=2*dx; int twoDxDy=2*(dx-dy);
-	// compute constants for Z
-	int twoDz=2*dz; int twoDzDy=2*(dz-dy);
-	// inialize position
-	int x=xs_; int y=ys_; int z=zs_;
-	
-	// loop to draw the line
-	for (int i=0; i<=dy; ++i)
+	// cylinder body (not present for a sphere)
+	if (lengthSquared > 0.0)
 	{
-		// draw voxel
-		DrawVoxelToVector(x,y,z,vector_);
+		const double radiusSquared = static_cast<double>(radius_*radius_);
+		// quadratic coefficient of the squared distance to the axis along a row (times lengthSquared)
+		const double a = lengthSquared - dz*dz;
+		// tolerance for rounding errors of the cylinder body
+		const double epsilon = 1e-9;
+
+		// w = p - start = (wx, wy, z - zStart), projection onto the axis: b + dz*(z - zStart)
+		const double wx = static_cast<double>(x_-xs_);
+		const double wy = static_cast<double>(y_-ys_);
+		const double b = wx*dx + wy*dy;
+		const double c = wx*wx + wy*wy;
+
+		// projection has to lie inside the segment: 0 <= b + dz*z <= lengthSquared
+		bool bodyHit = true;
+		double bodyBegin = -DBL_MAX;
+		double bodyEnd = DBL_MAX;
+		if (dz > 0.0)
+		{
+			bodyBegin = -b/dz;
+			bodyEnd = (lengthSquared-b)/dz;
+		}
+		else if (dz < 0.0)
+		{
+			bodyBegin = (lengthSquared-b)/dz;
+			bodyEnd = -b/dz;
+		}
+		else if (b < 0.0 || b > lengthSquared)
+			bodyHit = false;
 
-		// start of computing the next position
-		y+=yinc; 
-		if (ex>=0) {
-			x+=xinc; ex+=twoDxDy;
+		// squared distance to the axis has to be at most radius^2:
+		// a*z^2 - 2*b*dz*z + (lengthSquared*(c-radiusSquared) - b^2) <= 0
+		const double constant = lengthSquared*(c-radiusSquared) - b*b;
+		if (a > 0.0)
+		{
+			const double discriminant = b*b*dz*dz - a*constant;
+			if (discriminant >= 0.0)
+			{
+				const double root = sqrt(discriminant);
+				bodyBegin = std::max(bodyBegin, (b*dz - root)/a);
+				bodyEnd = std::min(bodyEnd, (b*dz + root)/a);
+			}
+			else
+				bodyHit = false;
 		}
-		else
-			ex+=twoDx;
-		
-		if (ez>=0) {
-			z+=zinc; ez+=twoDzDy;
+		else if (constant > 0.0)
+			bodyHit = false;	// segment along Z: distance to the axis is constant along the row
+
+		if (bodyHit && bodyBegin <= bodyEnd)
+		{
+			zBegin_ = std::min(zBegin_, zs_ + static_cast<int>(ceil(bodyBegin - epsilon)));
+			zEnd_ = std::max(zEnd_, zs_ + static_cast<int>(floor(bodyEnd + epsilon)));
 		}
-		else
-			ez+=twoDz;
-		// end of computing the next position
 	}
-}
-
-inline void DunGen::CVoxelCave::Bresenham3dZ(int xs_,int ys_,int zs_,int xe_,int ye_,int ze_, std::vector<SVoxelToDraw>& vector_)
-{	// input: endpoints
 
-	// compute directions
-	int xinc = (xe_<xs_) ? -1 : 1;
-	int yinc = (ye_<ys_) ? -1 : 1;
-	int zinc = (ze_<zs_) ? -1 : 1;
+	return zBegin_ <= zEnd_;
+}
 
-	// compute dx,dy,dz
-	int dx=abs (xe_-xs_);
-	int dy=abs (ye_-ys_);
-	int dz=abs (ze_-zs_);
+void DunGen::CVoxelCave::DrawCapsule(int xs_,int ys_,int zs_,int xe_,int ye_,int ze_, int radius_, int xBegin_, int xEnd_)
+{
+	// the capsule is scan converted row by row along Z, so every covered voxel is written exactly once
+	// only the voxels with xBegin_ <= x < xEnd_ are drawn
+	if (radius_ < 0)
+		return;
 
-	// compute initial decision parameters
-	int ey=2*dy-dz; int ex=2*dx-dz;
-	// compute constants for Y
-	int twoDy=2*dy; int twoDyDz=2*(dy-dz);
-	// compute constants for Z
-	int twoDx=2*dx; int twoDxDz=2*(dx-dz);
-	// inialize position
-	int x=xs_; int y=ys_; int z=zs_;
-	
-	// loop to draw the line
-	for (int i=0; i<=dz; ++i)
+	// degenerated capsule
+	if (xs_ == xe_ && ys_ == ye_ && zs_ == ze_)
 	{
-		// draw voxel
-		DrawVoxelToVector(x,y,z,vector_);
+		DrawSphere(xe_,ye_,ze_, radius_, xBegin_,xEnd_);
+		return;
+	}
 
-		/// start of computing the next position
-		z+=zinc; 
-		if (ey>=0) {
-			y+=yinc; ey+=twoDyDz;
+	// walk over the rows of the bounding rectangle in the XY-plane
+	const int iBegin = std::max(std::min(xs_,xe_)-radius_, xBegin_);
+	const int iEnd = std::min(std::max(xs_,xe_)+radius_+1, xEnd_);
+	for (int i = iBegin; i < iEnd; ++i)
+		for (int j = std::min(ys_,ye_)-radius_; j <= std::max(ys_,ye_)+radius_; ++j)
+		{
+			// fill the voxels of the span
+			int zBegin, zEnd;
+			if (GetCapsuleSpan(i,j, xs_,ys_,zs_,xe_,ye_,ze_, radius_, zBegin,zEnd))
+				VoxelSpace.FillRow(i,j,zBegin,zEnd+1);
 		}
-		else
-			ey+=twoDy;
-		
-		if (ex>=0) {
-			x+=xinc; ex+=twoDxDz;
+}
+
+void DunGen::CVoxelCave::DrawCapsuleDistances(int xs_,int ys_,int zs_,int xe_,int ye_,int ze_, int radius_, int xBegin_, int xEnd_)
+{
+	// only the voxels between the inner (radius - band) and the outer (radius + band) capsule can have a distance inside the band
+	// only the voxels with xBegin_ <= x < xEnd_ are drawn
+	if (radius_ < 0)
+		return;
+
+	// segment direction
+	const double dx = static_cast<double>(xe_-xs_);
+	const double dy = static_cast<double>(ye_-ys_);
+	const double dz = static_cast<double>(ze_-zs_);
+	const double lengthSquared = dx*dx + dy*dy + dz*dz;
+	const double inverseLengthSquared = (lengthSquared > 0.0) ? 1.0/lengthSquared : 0.0;
+	const double radius = static_cast<double>(radius_);
+
+	// walk over the rows of the bounding rectangle of the outer capsule in the XY-plane (inside the voxel space)
+	const int reach = radius_+CVoxelSpace::DistanceBand;
+	const int iBegin = std::max(std::max(std::min(xs_,xe_)-reach, xBegin_), 0);
+	const int iEnd = std::min(std::min(std::max(xs_,xe_)+reach+1, xEnd_), static_cast<int>(GetDimX()));
+	const int jBegin = std::max(std::min(ys_,ye_)-reach, 0);
+	const int jEnd = std::min(std::max(ys_,ye_)+reach+1, static_cast<int>(GetDimY()));
+	for (int i = iBegin; i < iEnd; ++i)
+		for (int j = jBegin; j < jEnd; ++j)
+		{
+			int zBegin, zEnd;
+			if (!GetCapsuleSpan(i,j, xs_,ys_,zs_,xe_,ye_,ze_, reach, zBegin,zEnd))
+				continue;
+			zBegin = std::max(zBegin, 0);
+			zEnd = std::min(zEnd, static_cast<int>(GetDimZ())-1);
+
+			// voxels inside the inner capsule are deeper than the band
+			int innerBegin = INT_MAX;
+			int innerEnd = INT_MIN;
+			if (radius_ >= CVoxelSpace::DistanceBand)
+				GetCapsuleSpan(i,j, xs_,ys_,zs_,xe_,ye_,ze_, radius_-CVoxelSpace::DistanceBand, innerBegin,innerEnd);
+
+			const double wx = static_cast<double>(i-xs_);
+			const double wy = static_cast<double>(j-ys_);
+			const double b = wx*dx + wy*dy;
+
+			for (int k = zBegin; k <= zEnd; ++k)
+			{
+				if (k >= innerBegin && k <= innerEnd)
+				{
+					k = innerEnd;
+					continue;
+				}
+
+				// only the voxels at the surface store distances
+				if (!VoxelSpace.HasDistance(i,j,k))
+					continue;
+
+				// nearest point on the segment
+				const double wz = static_cast<double>(k-zs_);
+				const double t = std::max(0.0, std::min(1.0, (b + wz*dz)*inverseLengthSquared));
+				const double ex = wx - t*dx;
+				const double ey = wy - t*dy;
+				const double ez = wz - t*dz;
+				const double distanceSquared = ex*ex + ey*ey + ez*ez;
+
+				// quantize: the sign has to match the occupancy drawn by the spans (0 is inside)
+				int value = static_cast<int>(floor((radius - sqrt(distanceSquared))*CVoxelSpace::DistanceScale + 0.5));
+				if (distanceSquared <= radius*radius + 1e-6)
+					value = std::max(value, 0);
+				else
+					value = std::min(value, -1);
+				if (value > CVoxelSpace::DistanceMax)
+					value = CVoxelSpace::DistanceMax;
+				else if (value < -CVoxelSpace::DistanceMax)
+					value = -CVoxelSpace::DistanceMax;
+
+				VoxelSpace.RaiseDistance(i,j,k,value);
+			}
 		}
-		else
-			ex+=twoDx;
-		// end of computing the next position
-	}
 }
 
-void DunGen::CVoxelCave::Bresenham3d(int xs_,int ys_,int z_s,int xe_,int ye_,int ze_, std::vector<SVoxelToDraw>& vector_)
+void DunGen::CVoxelCave::DrawSphere(int x_,int y_,int z_, int radius_, int xBegin_, int xEnd_)
 {
-	// compute axis lengths
-	int dx=abs (xe_-xs_);
-	int dy=abs (ye_-ys_);
-	int dz=abs (ze_-z_s);
+	if (radius_ < 0)
+		return;
+
+	// the span table holds the half length of every Z-row of the sphere
+	const std::vector<int>& spans = GetSphereSpans(radius_);
 
-	if ((dx>dy)&&(dx>dz)) Bresenham3dX(xs_,ys_,z_s,xe_,ye_,ze_,vector_);		// longest axis: X
-	else if (dy>dz) Bresenham3dY(xs_,ys_,z_s,xe_,ye_,ze_,vector_);				// longest axis: Y
-	else Bresenham3dZ(xs_,ys_,z_s,xe_,ye_,ze_,vector_);							// longest axis: Z
+	// walk over the rows of the bounding square in the XY-plane
+	const int iBegin = std::max(-radius_, xBegin_-x_);
+	const int iEnd = std::min(radius_+1, xEnd_-x_);
+	for (int i = iBegin; i<iEnd; ++i)
+	{
+		const int* spanRow = &spans[abs(i)*(radius_+1)];
+		for (int j = -radius_; j<=radius_; ++j)
+		{
+			// fill the row at once, if it intersects the sphere
+			const int halfLength = spanRow[abs(j)];
+			if (halfLength >= 0)
+				VoxelSpace.FillRow(x_+i,y_+j,z_-halfLength,z_+halfLength+1);
+		}
+	}
 }
 
-// ======================================================
-// further drawing functions for geometric primitives
-// ======================================================
+void DunGen::CVoxelCave::AddPrimitive(int xs_,int ys_,int zs_,int xe_,int ye_,int ze_, int radius_)
+{
+	SPrimitive primitive;
+	primitive.XStart = xs_;	primitive.YStart = ys_;	primitive.ZStart = zs_;
+	primitive.XEnd = xe_;	primitive.YEnd = ye_;	primitive.ZEnd = ze_;
+	primitive.Radius = radius_;
+	Primitives.push_back(primitive);
+}
 
-void DunGen::CVoxelCave::DrawCylinder(int xs_,int ys_,int zs_,int xe_,int ye_,int ze_, int radius_, irr::core::vector3d<double> left_, irr::core::vector3d<double> up_)
+void DunGen::CVoxelCave::RasterizePrimitives(bool distances_)
 {
-	// this algorithm uses three 3D Bresenhams to span a cylinder
-	// voxelblocks are used to draw, to close potential gaps that are caused by the 26-connectivity of the 3D Bresenham algorithm
-	// _Left und _Up are the vectors to span the top surface - to get the correct radius, they have to be normalized
+	// distances reach beyond the primitives
+	const int band = distances_ ? CVoxelSpace::DistanceBand : 0;
 
-	// decrement radius by one, because voxelblocks are drawn instead single voxels	
-	--radius_;
-	
-	// buffers for the spaning axis
-	std::vector<SVoxelToDraw> voxelVector1;
-	std::vector<SVoxelToDraw> voxelVector2; 
-	std::vector<SVoxelToDraw> voxelVector3; 
-
-	// parameters for the first bresenham:
-	int xn = d2i(radius_ * up_.X);
-	int yn = d2i(radius_ * up_.Y);
-	int zn = d2i(radius_ * up_.Z);
-
-	// start first Bresenham: cylinder top surface vertical
-	Bresenham3d(0,0,0,xn,yn,zn,voxelVector1);
-
-	// parameters for the second bresenham:
-	xn = d2i(radius_ * left_.X);
-	yn = d2i(radius_ * left_.Y);
-	zn = d2i(radius_ * left_.Z);
-	
-	// start second Bresenham: cylinder top surface horizontal
-	Bresenham3d(0,0,0,xn,yn,zn,voxelVector2);
-	// start third Bresenham: cylinder central axis
-	Bresenham3d(xs_,ys_,zs_,xe_,ye_,ze_,voxelVector3);
-
-	// preallocate memory
-	SVoxelToDraw actualVoxel1;
-	SVoxelToDraw actualVoxel2;
-	SVoxelToDraw actualVoxel3;
-	int xm, ym, zm;
-
-	// compute the squared radius for the inner loop
-	const int radiusSquared = radius_ * radius_;
-	
-	// iterate over the voxels of the 3 axis
-	for (unsigned int i=0; i<voxelVector1.size(); ++i)
-	{
-		actualVoxel1 = voxelVector1[i];
-		for (unsigned int j=0; j<voxelVector2.size(); ++j)
+	// the span tables are shared by all threads: compute them in advance (distances need the inner and the outer capsule)
+	for (unsigned int i=0; i<Primitives.size(); ++i)
+		if (Primitives[i].Radius >= band)
 		{
-			actualVoxel2 = voxelVector2[j];
+			GetSphereSpans(Primitives[i].Radius+band);
+			GetSphereSpans(Primitives[i].Radius-band);
+		}
+		else if (Primitives[i].Radius >= 0)
+			GetSphereSpans(Primitives[i].Radius+band);
+
+	// the voxel space is split up into slabs along X, each one brick thick:
+	// slabs share no brick and voxels only change from 0 to 1 (distances only grow), so they can be drawn in parallel without locking
+	const int slabThickness = static_cast<int>(CVoxelSpace::BrickSize);
+	const int slabCount = static_cast<int>(GetDimX()+CVoxelSpace::BrickSize-1) / slabThickness;
+	const int primitiveCount = static_cast<int>(Primitives.size());
 
-			// position relative to the center point of the top surface
-			xn = actualVoxel1.X + actualVoxel2.X;
-			yn = actualVoxel1.Y + actualVoxel2.Y;
-			zn = actualVoxel1.Z + actualVoxel2.Z;
+	#pragma omp parallel for schedule(dynamic)
+	for (int slab=0; slab<slabCount; ++slab)
+	{
+		const int xBegin = slab*slabThickness;
+		const int xEnd = xBegin+slabThickness;
 
-			// voxel on top surface of the cylinder?
-			if ((xn*xn+yn*yn+zn*zn) <= radiusSquared)
+		// draw all primitives, that overlap the slab
+		for (int i=0; i<primitiveCount; ++i)
+		{
+			const SPrimitive& primitive = Primitives[i];
+			if (std::min(primitive.XStart,primitive.XEnd)-primitive.Radius-band < xEnd
+				&& std::max(primitive.XStart,primitive.XEnd)+primitive.Radius+band >= xBegin)
 			{
-				// parameters for mirroring
-				xm = actualVoxel1.X - actualVoxel2.X;
-				ym = actualVoxel1.Y - actualVoxel2.Y;
-				zm = actualVoxel1.Z - actualVoxel2.Z;
+				if (distances_)
+					DrawCapsuleDistances(primitive.XStart,primitive.YStart,primitive.ZStart,
+						primitive.XEnd,primitive.YEnd,primitive.ZEnd, primitive.Radius, xBegin,xEnd);
+				else
+					DrawCapsule(primitive.XStart,primitive.YStart,primitive.ZStart,
+						primitive.XEnd,primitive.YEnd,primitive.ZEnd, primitive.Radius, xBegin,xEnd);
+			}
+		}
+	}
+}
+
+void DunGen::CVoxelCave::ComputeDistanceField()
+{
+	const unsigned int xMax = GetDimX() - SVoxelSpace::MinBorder;
+	const unsigned int yMax = GetDimY() - SVoxelSpace::MinBorder;
+	const unsigned int zMax = GetDimZ() - SVoxelSpace::MinBorder;
 
-				for (unsigned int k=0; k<voxelVector3.size(); ++k)
+	// the voxels at both sides of every 0<->1 junction store a distance
+	for (unsigned int i=SVoxelSpace::MinBorder; i<=xMax; ++i)
+		for (unsigned int j=SVoxelSpace::MinBorder; j<=yMax; ++j)
+			for (unsigned int k=SVoxelSpace::MinBorder, rowEnd=0; k<=zMax; ++k)
+			{
+				// skip brick rows without junctions
+				if (k >= rowEnd)
 				{
-					actualVoxel3 = voxelVector3[k];
-
-					// draw first voxelblock: one quadrant
-					DrawVoxelBlock(actualVoxel3.X+xn,actualVoxel3.Y+yn,actualVoxel3.Z+zn);
-					// mirroring 1
-					DrawVoxelBlock(actualVoxel3.X-xn,actualVoxel3.Y-yn,actualVoxel3.Z-zn);
-					// mirroring 2
-					DrawVoxelBlock(actualVoxel3.X+xm,actualVoxel3.Y+ym,actualVoxel3.Z+zm);
-					// mirroring 3
-					DrawVoxelBlock(actualVoxel3.X-xm,actualVoxel3.Y-ym,actualVoxel3.Z-zm);
+					rowEnd = GetBrickRowEnd(k,zMax+1);
+					if (IsRowWithoutJunction(i,j,k,rowEnd))
+					{
+						k = rowEnd-1;
+						continue;
+					}
 				}
+
+				const unsigned char value = GetVoxel(i,j,k) & 1;
+				if (value != (GetVoxel(i-1,j,k) & 1)) {VoxelSpace.EnableDistance(i,j,k); VoxelSpace.EnableDistance(i-1,j,k);}
+				if (value != (GetVoxel(i,j-1,k) & 1)) {VoxelSpace.EnableDistance(i,j,k); VoxelSpace.EnableDistance(i,j-1,k);}
+				if (value != (GetVoxel(i,j,k-1) & 1)) {VoxelSpace.EnableDistance(i,j,k); VoxelSpace.EnableDistance(i,j,k-1);}
 			}
-		}
-	}
+
+	// the distances are the union of the primitives
+	RasterizePrimitives(true);
 }
 
-void DunGen::CVoxelCave::DrawSphere(int x_,int y_,int z_, int radius_)
+const std::vector<int>& DunGen::CVoxelCave::GetSphereSpans(int radius_)
 {
-	// precompute and preallocate
+	if (SphereSpans.size() <= static_cast<unsigned int>(radius_))
+		SphereSpans.resize(radius_+1);
+
+	// table already computed?
+	std::vector<int>& spans = SphereSpans[radius_];
+	if (!spans.empty())
+		return spans;
+
+	// per row: largest k with x^2 + y^2 + k^2 <= radius^2, -1 if the row does not intersect the sphere
 	const int radiusSquared = radius_*radius_;
-	int xSquared;
-	int xSquaredPlusYSquared;
-	
-	// walk over the bounding cube of the sphere
-	for (int i = -radius_; i<=radius_; ++i)
-	{
-		// compute x^2
-		xSquared = i*i;
-		for (int j = -radius_; j<=radius_; ++j)
+	spans.resize((radius_+1)*(radius_+1));
+	for (int i=0; i<=radius_; ++i)
+		for (int j=0; j<=radius_; ++j)
 		{
-			// compute x^2 + y^2
-			xSquaredPlusYSquared = xSquared + j*j;
-			for (int k = -radius_; k<=radius_; ++k)
+			const int remainder = radiusSquared - i*i - j*j;
+			int k = -1;
+			if (remainder >= 0)
 			{
-				// test, if x^2 + y^2 + z^2 no larger than radius^2
-				// -> belongs to sphere -> draw voxel
-				if ((xSquaredPlusYSquared+k*k) <= radiusSquared)
-					SetVoxel(x_+i,y_+j,z_+k,1);
+				k = static_cast<int>(sqrt(static_cast<double>(remainder)));
+				while (k*k > remainder) --k;
+				while ((k+1)*(k+1) <= remainder) ++k;
 			}
+			spans[i*(radius_+1)+j] = k;
 		}
-	}
+
+	return spans;
 }
 
 // ======================================================
 // helper fuctions
 // ======================================================
 
-unsigned int DunGen::CVoxelCave::EstimateMeshComplexity() const
+unsigned int DunGen::CVoxelCave::EstimateMeshComplexity()
 {
-	unsigned int triangleCounter = 0;
+	const unsigned int bricksX = VoxelSpace.GetBricksX();
+	const unsigned int bricksY = VoxelSpace.GetBricksY();
+	const unsigned int bricksZ = VoxelSpace.GetBricksZ();
 
-	const unsigned int xMax = SVoxelSpace::DimX - SVoxelSpace::MinBorder;
-	const unsigned int yMax = SVoxelSpace::DimY - SVoxelSpace::MinBorder;
-	const unsigned int zMax = SVoxelSpace::DimZ - SVoxelSpace::MinBorder;
+	// the bricks, that have been written to since the last estimate
+	VoxelSpace.TakeChangedBricks(ChangedBricks);
 
-	// iterate over voxelspace
-	for (unsigned int i=SVoxelSpace::MinBorder; i<=xMax; ++i)
-		for (unsigned int j=SVoxelSpace::MinBorder; j<=yMax; ++j)
-			for (unsigned int k=SVoxelSpace::MinBorder; k<=zMax; ++k)
+	if (BrickJunctions.empty())
+	{
+		// first estimate for these dimensions: all bricks are counted
+		BrickJunctions.assign(bricksX*bricksY*bricksZ,0);
+		StaleBrickFlags.assign(bricksX*bricksY*bricksZ,0);
+		JunctionCount = 0;
+		StaleBricks.resize(BrickJunctions.size());
+		for (unsigned int i=0; i<StaleBricks.size(); ++i)
+			StaleBricks[i] = i;
+	}
+	else
+	{
+		// the junctions of a brick also depend on the bricks in front of it (negative X, Y and Z direction):
+		// a changed brick and the bricks behind it are stale
+		const unsigned int neighborOffsets[4] = {0, bricksY*bricksZ, bricksZ, 1};
+		StaleBricks.clear();
+		for (unsigned int i=0; i<ChangedBricks.size(); ++i)
+		{
+			const unsigned int brick = ChangedBricks[i];
+			const bool hasNeighbor[4] = {true, brick/(bricksY*bricksZ)+1 < bricksX, (brick/bricksZ)%bricksY+1 < bricksY, brick%bricksZ+1 < bricksZ};
+			for (unsigned int n=0; n<4; ++n)
 			{
-				// count the 0<->1 junctions
-				if (1 == GetVoxel(i-1,j,k) + GetVoxel(i,j,k)) {++triangleCounter;}
-				if (1 == GetVoxel(i,j-1,k) + GetVoxel(i,j,k)) {++triangleCounter;}
-				if (1 == GetVoxel(i,j,k-1) + GetVoxel(i,j,k)) {++triangleCounter;}
+				const unsigned int stale = brick + neighborOffsets[n];
+				if (hasNeighbor[n] && !StaleBrickFlags[stale])
+				{
+					StaleBrickFlags[stale] = 1;
+					StaleBricks.push_back(stale);
+				}
 			}
+		}
+		for (unsigned int i=0; i<StaleBricks.size(); ++i)
+			StaleBrickFlags[StaleBricks[i]] = 0;
+	}
+
+	// count the junctions of the stale bricks again
+	const int staleCount = static_cast<int>(StaleBricks.size());
+	StaleJunctions.resize(StaleBricks.size());
+	#pragma omp parallel for schedule(dynamic)
+	for (int i=0; i<staleCount; ++i)
+	{
+		const unsigned int stale = StaleBricks[i];
+		StaleJunctions[i] = CountBrickJunctions((stale/(bricksY*bricksZ))*CVoxelSpace::BrickSize,
+			((stale/bricksZ)%bricksY)*CVoxelSpace::BrickSize, (stale%bricksZ)*CVoxelSpace::BrickSize);
+	}
+
+	// update the sum: the old count of a stale brick is replaced by the new one
+	for (int i=0; i<staleCount; ++i)
+	{
+		const unsigned int stale = StaleBricks[i];
+		JunctionCount = JunctionCount - BrickJunctions[stale] + StaleJunctions[i];
+		BrickJunctions[stale] = StaleJunctions[i];
+	}
 
 	// per junction, 2 triangles are needed
-	return triangleCounter*2;
+	return JunctionCount*2;
+}
+
+unsigned int DunGen::CVoxelCave::CountBrickJunctions(unsigned int x_, unsigned int y_, unsigned int z_) const
+{
+	// only the junctions of the voxels [MinBorder,Dim-MinBorder] are counted
+	const unsigned int xMax = GetDimX() - SVoxelSpace::MinBorder + 1;
+	const unsigned int yMax = GetDimY() - SVoxelSpace::MinBorder + 1;
+	const unsigned int zMax = GetDimZ() - SVoxelSpace::MinBorder + 1;
+	const unsigned int xBegin = x_ > SVoxelSpace::MinBorder ? x_ : SVoxelSpace::MinBorder;
+	const unsigned int yBegin = y_ > SVoxelSpace::MinBorder ? y_ : SVoxelSpace::MinBorder;
+	const unsigned int zBegin = z_ > SVoxelSpace::MinBorder ? z_ : SVoxelSpace::MinBorder;
+	const unsigned int xEnd = x_+CVoxelSpace::BrickSize < xMax ? x_+CVoxelSpace::BrickSize : xMax;
+	const unsigned int yEnd = y_+CVoxelSpace::BrickSize < yMax ? y_+CVoxelSpace::BrickSize : yMax;
+	const unsigned int zEnd = z_+CVoxelSpace::BrickSize < zMax ? z_+CVoxelSpace::BrickSize : zMax;
+	if (xBegin >= xEnd || yBegin >= yEnd || zBegin >= zEnd)
+		return 0;
+
+	unsigned int junctionCounter = 0;
+	const unsigned int mask = CVoxelClassifier::GetRowMask(z_,zBegin,zEnd);
+	for (unsigned int i=xBegin; i<xEnd; ++i)
+		for (unsigned int j=yBegin; j<yEnd; ++j)
+		{
+			// skip brick rows without junctions
+			if (IsRowWithoutJunction(i,j,zBegin,zEnd))
+				continue;
+
+			// count the 0<->1 junctions a brick row at once
+			junctionCounter += Classifier.GetJunctionCount(i,j,z_,mask);
+		}
+
+	return junctionCounter;
 }
 
 
@@ -380,333 +541,544 @@ unsigned int DunGen::CVoxelCave::EstimateMeshComplexity() const
 // drawing functions for turtle graphics
 // ======================================================
 
-void DunGen::CVoxelCave::Draw(std::string instructions_,
+void DunGen::CVoxelCave::Draw(CLSystemExpansion& expansion_, const CLSystem::STurtlePrediction* prediction_,
 	double angleYaw_, double anglePitch_, double angleRoll_, double radiusStart_, double radiusFactor_, double radiusDecrement_)
 {
-	// factors for degree measure to radian measure
-	const double angleYawRAD = angleYaw_ * M_DegToRad;
-	const double angleNickRAD = anglePitch_ * M_DegToRad;
-	const double angleRollRAD = angleRoll_ * M_DegToRad;
+	// clear the voxel space (only the region written by the last generation)
+	VoxelSpace.Clear();
+	DistanceFieldValid = false;
+	ErosionCount = 0;
+	if (PrintToConsole)
+		std::cout << "cleared " << VoxelSpace.GetClearedBytes() << " bytes of the voxel space" << std::endl;
 
-	// compute sinus and cosinus values for the given angles
-	// for negative angles: cos(-x) = cos(x), sin(-x) = -sin(x)
-	const double cosAngleYaw = cos(angleYawRAD);	
-	const double sinAngleYaw = sin(angleYawRAD);
-	const double cosAngleNick = cos(angleNickRAD);
-	const double sinAngleNick = sin(angleNickRAD);
-	const double cosAngleRoll = cos(angleRollRAD);
-	const double sinAngleRoll = sin(angleRollRAD);
+	// the arena of turtle states is sized by the predicted stack depth once (large depths are grown on demand)
+	if (prediction_ && static_cast<double>(TurtleStates.size()) < std::min(prediction_->MaxDepth, static_cast<double>(MaxReservedTurtleStates)))
+		TurtleStates.resize(static_cast<unsigned int>(std::min(prediction_->MaxDepth, static_cast<double>(MaxReservedTurtleStates))));
+
+	// the turtle graphic is interpreted only, if the derivation or the angles have changed:
+	// the unscaled lines do not depend on the voxel space, the border and the radii
+	if (!TurtleSegmentsValid || angleYaw_ != TurtleAngleYaw || anglePitch_ != TurtleAnglePitch || angleRoll_ != TurtleAngleRoll
+		|| !(expansion_ == TurtleExpansion))
+	{
+		// too many lines to keep them (predicted): the first interpretation only computes the exact bounding box,
+		// the second one scales the lines
+		const bool keepSegments = !prediction_ || prediction_->Lines <= static_cast<double>(MaxTurtleSegments);
+		if (PrintToConsole && !keepSegments)
+			std::cout << "interpreting " << prediction_->Lines << " lines twice" << std::endl;
+		InterpretTurtleGraphic(expansion_, angleYaw_, anglePitch_, angleRoll_, NULL, keepSegments);
+	}
+	else if (PrintToConsole)
+		std::cout << "reusing the interpreted turtle graphic" << std::endl;
+
+	// the lines are scaled into a list of primitives first, that are rasterized afterwards
+	Primitives.clear();
 
-	// clear the voxel space
-	memset(Voxel,0,sizeof(unsigned char)*SVoxelSpace::DimX*SVoxelSpace::DimY*SVoxelSpace::DimZ);
-		
-	// state stack
-	std::stack<STurtleState> stateStack;
-	// actual stat
-	STurtleState actState;
-	// previous state
-	STurtleState oldState;
-		
-	// for scaling turtle graphic into voxel space
-	double xMin = 0.0;	double xMax = 0.0;
-	double yMin = 0.0;	double yMax = 0.0;
-	double zMin = 0.0;	double zMax = 0.0;
-	double xMid, yMid, zMid;
-	
-	// lenght of a line
-	double fValue = 1.0;
-	// set starting postion
-	actState.Position = irr::core::vector3d<double>(0.0,0.0,0.0);
 	// clamp start radius
 	if (radiusStart_<MinDrawRadius)
 		radiusStart_ = MinDrawRadius;
 
-	// preallocate memory
-	int xOld, yOld, zOld, xNew, yNew, zNew, radiusNew;
-	
-	// counter to display progress
-	unsigned int counterAct = 0;
-	// 1 point = 100/VoxelspaceX percent
-	// if there are fewer drawing instructions than VoxelspaceX, the progress bar will be shorter
-	const unsigned int counterInc = instructions_.size()/SVoxelSpace::DimX;
-
-	// mode 0: compute bounding box (for rescaling), mode 1: draw scaled graphic
-	unsigned int mode = 0;
-
-	// append end symbol, so that aggregation of long lines has a symbol !='F'/'[' to stop
-	instructions_ += ' ';
-	// loop through drawing modes
-	while (mode < 2)
-	{
-		// starting values
-		actState.Radius = radiusStart_;
-		actState.Front = irr::core::vector3d<double>(1.0,0.0,0.0);
-		actState.Left = irr::core::vector3d<double>(0.0,0.0,1.0);
-		actState.Up = irr::core::vector3d<double>(0.0,1.0,0.0);
-
-		// clear stack
-		while (!stateStack.empty()) stateStack.pop();
-
-		// parse drawing instructions
-		for (unsigned int i=0; i<instructions_.size(); ++i)
+	// the radius may not exceed the voxel space (small voxel spaces)
+	const double maxRadius = 0.5*static_cast<double>(std::min(GetDimX(),std::min(GetDimY(),GetDimZ())) - 3) - Border;
+	const double minDrawRadius = std::min(static_cast<double>(MinDrawRadius), maxRadius);
+	if (radiusStart_>maxRadius)
+		radiusStart_ = maxRadius;
+
+	// drawing radius after n reductions ('!')
+	STurtleScaling scaling;
+	scaling.Radii.resize(TurtleMaxReductions+1);
+	double radius = radiusStart_;
+	for (unsigned int n=0; n<scaling.Radii.size(); ++n)
+	{
+		scaling.Radii[n] = static_cast<int>(radius);
+		radius = radiusFactor_ * radius - radiusDecrement_;
+		if (radius < minDrawRadius)
+			radius = minDrawRadius;
+	}
+
+	// for scaling turtle graphic into voxel space
+	double xMin = TurtleMin.X;	double xMax = TurtleMax.X;
+	double yMin = TurtleMin.Y;	double yMax = TurtleMax.Y;
+	double zMin = TurtleMin.Z;	double zMax = TurtleMax.Z;
+
+	// compute center
+	const double xMid = xMin + 0.5*(xMax - xMin);
+	const double yMid = yMin + 0.5*(yMax - yMin);
+	const double zMid = zMin + 0.5*(zMax - zMin);
+
+	/// adjust invalid values
+	if (xMax==xMin)	++xMax;
+	if (yMax==yMin)	++yMax;
+	if (zMax==zMin)	++zMax;
+
+	// border offset = 2*radius + 2*border
+	// + 1 because voxel space has a side length 1 smaller than amount of voxels at that side
+	// + 1 because of rounding issues integer <-> floating point
+	int borderOffset = 2 * (Border + static_cast<int>(radiusStart_)) + 2;
+	// usable size of the voxel space (at least 1, if the voxel space is very small)
+	const int sizeX = std::max(static_cast<int>(GetDimX())-borderOffset, 1);
+	const int sizeY = std::max(static_cast<int>(GetDimY())-borderOffset, 1);
+	const int sizeZ = std::max(static_cast<int>(GetDimZ())-borderOffset, 1);
+	// compute scaling factors
+	double scaleX = static_cast<double>(sizeX) / (xMax-xMin);
+	double scaleY = static_cast<double>(sizeY) / (yMax-yMin);
+	double scaleZ = static_cast<double>(sizeZ) / (zMax-zMin);
+
+	// set line length to minimum scale factor
+	// so the graphic is scaled uniformly along all dimensions
+	scaling.FValue = std::min(scaleX,std::min(scaleY,scaleZ));
+
+	// set starting point
+	// the center point of the voxel graphic shall be identical with the center point of the voxel space
+	scaling.Start.X = 0.5*static_cast<double>(GetDimX()-1) - scaling.FValue*xMid;
+	scaling.Start.Y = 0.5*static_cast<double>(GetDimY()-1) - scaling.FValue*yMid;
+	scaling.Start.Z = 0.5*static_cast<double>(GetDimZ()-1) - scaling.FValue*zMid;
+
+	// draw sphere at start
+	const int xStart = static_cast<int>(scaling.Start.X);
+	const int yStart = static_cast<int>(scaling.Start.Y);
+	const int zStart = static_cast<int>(scaling.Start.Z);
+	AddPrimitive(xStart,yStart,zStart,xStart,yStart,zStart, static_cast<int>(radiusStart_));
+
+	if (PrintToConsole) std::cout << "start drawing with F-length: " << scaling.FValue
+		<< " at: " << scaling.Start.X << " , " << scaling.Start.Y << " , " << scaling.Start.Z << std::endl;
+
+	if (TurtleSegmentsValid)
+	{
+		// counter to display progress
+		unsigned int counterAct = 0;
+		// 1 point = 100/VoxelspaceX percent
+		// if there are fewer lines than VoxelspaceX, the progress bar will be shorter
+		const unsigned int counterInc = TurtleSegments.size()/GetDimX();
+
+		// scale the lines
+		for (unsigned int i=0; i<TurtleSegments.size(); ++i)
 		{
 			// progress output
-			if (PrintToConsole && (1 == mode) && (i-counterAct > counterInc))
+			if (PrintToConsole && (i-counterAct > counterInc))
 			{
 				counterAct+=counterInc;
 				std::cout << ".";
 			}
 
-			// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-			// begin of evaluation of drawing instruction
-			// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-			switch (instructions_[i])
-			{
-			case 'F': // draw line
-				{
-					oldState = actState;
+			AddTurtleSegment(TurtleSegments[i], scaling);
+		}
 
-					// compute new position
-					actState.Position += fValue*actState.Front;
+		if (PrintToConsole) std::cout << std::endl;
+	}
+	else
+	{
+		// too many lines to keep them: interpret the turtle graphic again and scale the lines directly
+		InterpretTurtleGraphic(expansion_, angleYaw_, anglePitch_, angleRoll_, &scaling, false);
+	}
 
-					// optimization: aggregate long lines (several 'F' repeating)
-					while ('F' == instructions_[i+1] || '[' == instructions_[i+1])
-					{
-						if ('F' == instructions_[i+1])
-							actState.Position += fValue*actState.Front;
-						else
-							stateStack.push(actState);
-						++i;
-					}
+	// rasterize the primitives
+	if (PrintToConsole) std::cout << "rasterizing " << Primitives.size() << " primitives ..." << std::endl;
+	RasterizePrimitives(false);
 
-					if (0 == mode)
-					{
-						// actualize bounding box
-						if (actState.Position.X < xMin) xMin = actState.Position.X;
-						if (actState.Position.X > xMax) xMax = actState.Position.X;
-						if (actState.Position.Y < yMin) yMin = actState.Position.Y;
-						if (actState.Position.Y > yMax) yMax = actState.Position.Y;
-						if (actState.Position.Z < zMin) zMin = actState.Position.Z;
-						if (actState.Position.Z > zMax) zMax = actState.Position.Z;	
-					}
-					else
-					{
-						// convert coordinates
-						xOld = static_cast<int>(oldState.Position.X);
-						yOld = static_cast<int>(oldState.Position.Y);
-						zOld = static_cast<int>(oldState.Position.Z);
-						xNew = static_cast<int>(actState.Position.X);
-						yNew = static_cast<int>(actState.Position.Y);
-						zNew = static_cast<int>(actState.Position.Z);
-						radiusNew = static_cast<int>(actState.Radius);
-
-						// only draw, if changes make it necessary
-						if( xOld!=xNew || yOld!=yNew || zOld!=zNew || radiusNew<static_cast<int>(oldState.Radius) )
-						{
-							// line, if a coordinate has changed more than 1 voxel
-							if ((abs(xOld-xNew) > 1)||(abs(yOld-yNew) > 1)||(abs(zOld-zNew) > 1))
-								DrawCylinder(xOld,yOld,zOld,xNew,yNew,zNew, radiusNew, actState.Left, actState.Up);	
-							// end: sphere to close gap to successor line (can have other radius or direction)
-							DrawSphere(xNew,yNew,zNew, radiusNew);
-						}
-					}
-				}
-				break;
-			
-			case '!': // reduce radius
-				{
-					actState.Radius= radiusFactor_ * actState.Radius - radiusDecrement_;
-					if (actState.Radius < MinDrawRadius)
-						actState.Radius = MinDrawRadius;
-				}
-				break;
+	EnsureIntegrity();
 
-			// ~-~-~-~-~-~-~-~-
-			// stack operations
-			// ~-~-~-~-~-~-~-~-
-			case '[': // push on stack
-				{
-					stateStack.push(actState);
-				}
-				break;
+	// the distance field needs the final surface
+	if (DistanceFieldEnabled)
+	{
+		if (PrintToConsole) std::cout << "computing distance field ..." << std::endl;
+		ComputeDistanceField();
+		DistanceFieldValid = true;
+	}
 
-			case ']': // take from stack
-				{
-					if (!stateStack.empty())
-					{
-						actState = stateStack.top();
-						stateStack.pop();
-					}
-				}
-				break;
+	// release the storage of bricks, that have been filled completely
+	VoxelSpace.Compact();
 
-			// ~-~-~-~-~
-			// rotations
-			// ~-~-~-~-~
-			// angles are in mathematical positive direction
+} // end Draw
 
-			case '+': // rotate around Up by AngleYaw (left): R_up(AngleYaw)
-				{
-					// compute new coordinate system vectors
-					// normalize for numerical stability
-					actState.Front = cosAngleYaw * actState.Front + sinAngleYaw * actState.Left;
-					actState.Front.normalize();
-					// use cross product for second vector (also for numerical stability)
-					actState.Left = actState.Front.crossProduct(actState.Up);
-					actState.Left.normalize();
-				}
-				break;
+void DunGen::CVoxelCave::AddTurtleSegment(const STurtleSegment& segment_, const STurtleScaling& scaling_)
+{
+	// convert coordinates
+	const int xOld = static_cast<int>(scaling_.Start.X + scaling_.FValue*segment_.Start.X);
+	const int yOld = static_cast<int>(scaling_.Start.Y + scaling_.FValue*segment_.Start.Y);
+	const int zOld = static_cast<int>(scaling_.Start.Z + scaling_.FValue*segment_.Start.Z);
+	const int xNew = static_cast<int>(scaling_.Start.X + scaling_.FValue*segment_.End.X);
+	const int yNew = static_cast<int>(scaling_.Start.Y + scaling_.FValue*segment_.End.Y);
+	const int zNew = static_cast<int>(scaling_.Start.Z + scaling_.FValue*segment_.End.Z);
+
+	// only draw, if changes make it necessary
+	if (xOld!=xNew || yOld!=yNew || zOld!=zNew)
+	{
+		// line, if a coordinate has changed more than 1 voxel,
+		// the capsule ends with a sphere to close the gap to the successor line (can have other radius or direction)
+		if ((abs(xOld-xNew) > 1)||(abs(yOld-yNew) > 1)||(abs(zOld-zNew) > 1))
+			AddPrimitive(xOld,yOld,zOld,xNew,yNew,zNew, scaling_.Radii[segment_.Reductions]);
+		else
+			AddPrimitive(xNew,yNew,zNew,xNew,yNew,zNew, scaling_.Radii[segment_.Reductions]);
+	}
+}
 
-			case '-': // rotate around Up by -AngleYaw (right): R_up(-AngleYaw)
-				{
-					// compute new coordinate system vectors
-					actState.Front = cosAngleYaw * actState.Front - sinAngleYaw * actState.Left;
-					actState.Front.normalize();
-					actState.Left = actState.Front.crossProduct(actState.Up);
-					actState.Left.normalize();
-				}
-				break;
+inline DunGen::CVoxelCave::STurtleOp DunGen::CVoxelCave::ReadTurtleOp(CLSystemExpansion& expansion_) const
+{
+	STurtleOp op;
+	for (char symbol = expansion_.Next(); symbol; symbol = expansion_.Next())
+	{
+		op.Count = 1;
 
-			case 'u': // rotate around Left by AnglePitch (down): R_left(AnglePitch)
+		switch (symbol)
+		{
+		case 'F': // runs of lines and radius reductions
+		case '!':
+			{
+				op.Instruction = symbol;
+				for (char next = expansion_.Peek(); symbol == next || IsIgnoredTurtleSymbol(next); next = expansion_.Peek())
+					if (symbol == expansion_.Next())
+						++op.Count;
+			}
+			return op;
+
+		case '+': // runs of rotations around the same axis: positive and negative directions cancel each other
+		case '-':
+		case 'u':
+		case 'o':
+		case 'z':
+		case 'g':
+			{
+				const char positive = ('+' == symbol || '-' == symbol) ? '+' : (('u' == symbol || 'o' == symbol) ? 'u' : 'z');
+				const char negative = ('+' == positive) ? '-' : (('u' == positive) ? 'o' : 'g');
+				op.Instruction = positive;
+				op.Count = (positive == symbol) ? 1 : -1;
+				for (char next = expansion_.Peek(); positive == next || negative == next || IsIgnoredTurtleSymbol(next); next = expansion_.Peek())
 				{
-					// compute new coordinate system vectors
-					actState.Front = cosAngleNick * actState.Front - sinAngleNick * actState.Up;
-					actState.Front.normalize();	
-					actState.Up = actState.Left.crossProduct(actState.Front);
-					actState.Up.normalize();
+					next = expansion_.Next();
+					if (positive == next)
+						++op.Count;
+					else if (negative == next)
+						--op.Count;
 				}
-				break;
+				if (0 != op.Count)
+					return op;
+			}
+			break;
 
-			case 'o': // rotate around Left by -AnglePitch (up): R_left(-AnglePitch)
+		case '|': // runs of turnarounds: only an odd number turns around
+			{
+				op.Instruction = symbol;
+				for (char next = expansion_.Peek(); '|' == next || IsIgnoredTurtleSymbol(next); next = expansion_.Peek())
+					if ('|' == expansion_.Next())
+						++op.Count;
+				if (op.Count & 1)
 				{
-					// compute new coordinate system vectors
-					actState.Front = cosAngleNick * actState.Front + sinAngleNick * actState.Up;
-					actState.Front.normalize();	
-					actState.Up = actState.Left.crossProduct(actState.Front);
-					actState.Up.normalize();
+					op.Count = 1;
+					return op;
 				}
-				break;
+			}
+			break;
+
+		case '$': // runs of horizontal orientations: the first one is sufficient
+			{
+				op.Instruction = symbol;
+				while ('$' == expansion_.Peek() || IsIgnoredTurtleSymbol(expansion_.Peek()))
+					expansion_.Next();
+			}
+			return op;
+
+		case '[': // stack operations are not merged
+		case ']':
+			op.Instruction = symbol;
+			return op;
+		}
+
+		// other symbols are ignored by the turtle
+	}
+
+	// end of the derivation
+	op.Instruction = 0;
+	op.Count = 0;
+	return op;
+}
+
+inline bool DunGen::CVoxelCave::IsIgnoredTurtleSymbol(char symbol_) const
+{
+	return TurtleIgnoredSymbols[static_cast<unsigned char>(symbol_)];
+}
+
+inline void DunGen::CVoxelCave::GetTurtleRotation(unsigned int axis_, int count_, double& cos_, double& sin_) const
+{
+	if (count_ >= -MaxTabulatedRotation && count_ <= MaxTabulatedRotation)
+	{
+		cos_ = TurtleRotationCos[axis_][count_+MaxTabulatedRotation];
+		sin_ = TurtleRotationSin[axis_][count_+MaxTabulatedRotation];
+	}
+	else
+	{
+		cos_ = cos(count_*TurtleRotationAngles[axis_]);
+		sin_ = sin(count_*TurtleRotationAngles[axis_]);
+	}
+}
+
+inline void DunGen::CVoxelCave::PushTurtleState(const STurtleState& state_, unsigned int& depth_)
+{
+	// the arena grows only, if the depth has not been reached before
+	if (depth_ < TurtleStates.size())
+		TurtleStates[depth_] = state_;
+	else
+		TurtleStates.push_back(state_);
+
+	++depth_;
+	if (depth_ > TurtlePeakDepth)
+		TurtlePeakDepth = depth_;
+}
 
-			case 'z': // rotate around Front by AngleRoll (clockwise): R_front(AngleRoll)
+void DunGen::CVoxelCave::InterpretTurtleGraphic(CLSystemExpansion& expansion_, double angleYaw_, double anglePitch_, double angleRoll_, const STurtleScaling* scaling_, bool keepSegments_)
+{
+	if (PrintToConsole)
+		std::cout << "interpreting turtle graphic ..." << std::endl;
+
+	// factors for degree measure to radian measure
+	const double angleYawRAD = angleYaw_ * M_DegToRad;
+	const double angleNickRAD = anglePitch_ * M_DegToRad;
+	const double angleRollRAD = angleRoll_ * M_DegToRad;
+
+	// compute sinus and cosinus values for the given angles
+	// for negative angles: cos(-x) = cos(x), sin(-x) = -sin(x)
+	const double cosAngleYaw = cos(angleYawRAD);	
+	const double sinAngleYaw = sin(angleYawRAD);
+	const double cosAngleNick = cos(angleNickRAD);
+	const double sinAngleNick = sin(angleNickRAD);
+	const double cosAngleRoll = cos(angleRollRAD);
+	const double sinAngleRoll = sin(angleRollRAD);
+
+	// tabulate the rotations of the merged runs per axis, a single rotation uses the values above
+	const double cosAngles[3] = {cosAngleYaw, cosAngleNick, cosAngleRoll};
+	const double sinAngles[3] = {sinAngleYaw, sinAngleNick, sinAngleRoll};
+	TurtleRotationAngles[0] = angleYawRAD;
+	TurtleRotationAngles[1] = angleNickRAD;
+	TurtleRotationAngles[2] = angleRollRAD;
+	for (unsigned int axis=0; axis<3; ++axis)
+		for (int count=-MaxTabulatedRotation; count<=MaxTabulatedRotation; ++count)
+		{
+			const bool single = (1 == abs(count));
+			TurtleRotationCos[axis][count+MaxTabulatedRotation] = single ? cosAngles[axis] : cos(count*TurtleRotationAngles[axis]);
+			TurtleRotationSin[axis][count+MaxTabulatedRotation] = single ? count*sinAngles[axis] : sin(count*TurtleRotationAngles[axis]);
+		}
+
+	// the unscaled lines are recorded (if there are not too many)
+	unsigned int segmentCount = 0;
+	if (!scaling_)
+	{
+		TurtleSegmentsValid = false;
+		if (keepSegments_)
+			TurtleSegments.clear();
+		else
+			std::vector<STurtleSegment>().swap(TurtleSegments);
+		TurtleMin.set(0.0,0.0,0.0);
+		TurtleMax.set(0.0,0.0,0.0);
+		TurtleMaxReductions = 0;
+	}
+
+	// state stack: the arena of states is kept between the interpretations, depth is the number of pushed states
+	unsigned int depth = 0;
+	TurtlePeakDepth = 0;
+	// actual state
+	STurtleState actState;
+	// line to record
+	STurtleSegment segment;
+
+	// starting values: F-length 1 at the origin
+	actState.Position = irr::core::vector3d<double>(0.0,0.0,0.0);
+	actState.Front = irr::core::vector3d<double>(1.0,0.0,0.0);
+	actState.Left = irr::core::vector3d<double>(0.0,0.0,1.0);
+	actState.Up = irr::core::vector3d<double>(0.0,1.0,0.0);
+	actState.Reductions = 0;
+
+	// parse drawing instructions, run by run (with one instruction look ahead)
+	expansion_.Reset();
+	STurtleOp op;
+	STurtleOp nextOp = ReadTurtleOp(expansion_);
+	while (nextOp.Instruction)
+	{
+		op = nextOp;
+		nextOp = ReadTurtleOp(expansion_);
+
+		// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+		// begin of evaluation of drawing instruction
+		// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+		switch (op.Instruction)
+		{
+		case 'F': // draw line (Count times)
+			{
+				segment.Start = actState.Position;
+
+				// compute new position
+				actState.Position += static_cast<double>(op.Count) * actState.Front;
+
+				// optimization: aggregate long lines (lines only interrupted by '[')
+				while ('F' == nextOp.Instruction || '[' == nextOp.Instruction)
 				{
-					// compute new coordinate system vectors
-					actState.Left = cosAngleRoll * actState.Left + sinAngleRoll * actState.Up;
-					actState.Left.normalize();
-					actState.Up = actState.Left.crossProduct(actState.Front);
-					actState.Up.normalize();
+					if ('F' == nextOp.Instruction)
+						actState.Position += static_cast<double>(nextOp.Count) * actState.Front;
+					else
+						PushTurtleState(actState, depth);
+					nextOp = ReadTurtleOp(expansion_);
 				}
-				break;
 
-			case 'g': // rotate around Front by AngleRoll (counterclockwise): R_front(AngleRoll)
+				segment.End = actState.Position;
+				segment.Reductions = actState.Reductions;
+				++segmentCount;
+
+				if (scaling_)
 				{
-					// compute new coordinate system vectors
-					actState.Left = cosAngleRoll * actState.Left - sinAngleRoll * actState.Up;
-					actState.Left.normalize();
-					actState.Up = actState.Left.crossProduct(actState.Front);
-					actState.Up.normalize();
+					AddTurtleSegment(segment, *scaling_);
+					break;
 				}
-				break;
 
-			case '|': // rotate around Up by 180 degrees
+				// keep the line, release the lines, if there are too many
+				if (keepSegments_ && segmentCount <= MaxTurtleSegments)
+					TurtleSegments.push_back(segment);
+				else if (!TurtleSegments.empty())
+					std::vector<STurtleSegment>().swap(TurtleSegments);
+
+				// actualize bounding box
+				if (actState.Position.X < TurtleMin.X) TurtleMin.X = actState.Position.X;
+				if (actState.Position.X > TurtleMax.X) TurtleMax.X = actState.Position.X;
+				if (actState.Position.Y < TurtleMin.Y) TurtleMin.Y = actState.Position.Y;
+				if (actState.Position.Y > TurtleMax.Y) TurtleMax.Y = actState.Position.Y;
+				if (actState.Position.Z < TurtleMin.Z) TurtleMin.Z = actState.Position.Z;
+				if (actState.Position.Z > TurtleMax.Z) TurtleMax.Z = actState.Position.Z;
+			}
+			break;
+		
+		case '!': // reduce radius (Count times)
+			{
+				actState.Reductions += op.Count;
+				if (actState.Reductions > TurtleMaxReductions)
+					TurtleMaxReductions = actState.Reductions;
+			}
+			break;
+
+		// ~-~-~-~-~-~-~-~-
+		// stack operations
+		// ~-~-~-~-~-~-~-~-
+		case '[': // push on stack
+			{
+				PushTurtleState(actState, depth);
+			}
+			break;
+
+		case ']': // take from stack
+			{
+				if (depth > 0)
 				{
-					actState.Front = -actState.Front;
-					actState.Left = -actState.Left;
+					--depth;
+					actState = TurtleStates[depth];
 				}
-				break;
+			}
+			break;
 
-			case '$': // orient turtle to the XZ-plane (horizontal)
-				// -> Front und Left shall span the XZ-plane
-				{
-					// Up is vertical to the XZ-plane
-					actState.Up = irr::core::vector3d<double>(0,1,0);
+		// ~-~-~-~-~
+		// rotations
+		// ~-~-~-~-~
+		// angles are in mathematical positive direction,
+		// Count repeated rotations are done as one rotation by Count*angle (negative Count: opposite direction)
 
-					// values to test for most numerical stable vector:
-					// the vector that is more perpendicular to Up
-					double leftValue = abs(actState.Up.dotProduct(actState.Left));
-					double frontValue = abs(actState.Up.dotProduct(actState.Front));
+		case '+': // rotate around Up by Count*AngleYaw (left, '-': right): R_up(Count*AngleYaw)
+			{
+				double cosAngle, sinAngle;
+				GetTurtleRotation(0,op.Count,cosAngle,sinAngle);
+
+				// compute new coordinate system vectors
+				// normalize for numerical stability
+				actState.Front = cosAngle * actState.Front + sinAngle * actState.Left;
+				actState.Front.normalize();
+				// use cross product for second vector (also for numerical stability)
+				actState.Left = actState.Front.crossProduct(actState.Up);
+				actState.Left.normalize();
+			}
+			break;
 
-					// compute remaining vectors
-					// normalize for numerical stability
-					if (leftValue<frontValue)	// Left is more stable
-					{
-						// compute Front
-						actState.Front = actState.Up.crossProduct(actState.Left);
-						actState.Front.normalize();
-						// then Left
-						actState.Left = actState.Front.crossProduct(actState.Up);
-						actState.Left.normalize();
-					}
-					else // Front is more stable
-					{
-						// compute Left
-						actState.Left = actState.Front.crossProduct(actState.Up);
-						actState.Left.normalize();
-						// then Front
-						actState.Front = actState.Up.crossProduct(actState.Left);
-						actState.Front.normalize();
-					}	
-				}
-				break;
-			
-			} // end switch
-			
-			// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-			// end of evaluation of drawing instruction
-			// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+		case 'u': // rotate around Left by Count*AnglePitch (down, 'o': up): R_left(Count*AnglePitch)
+			{
+				double cosAngle, sinAngle;
+				GetTurtleRotation(1,op.Count,cosAngle,sinAngle);
+
+				// compute new coordinate system vectors
+				actState.Front = cosAngle * actState.Front - sinAngle * actState.Up;
+				actState.Front.normalize();	
+				actState.Up = actState.Left.crossProduct(actState.Front);
+				actState.Up.normalize();
+			}
+			break;
 
-		} // end for
+		case 'z': // rotate around Front by Count*AngleRoll (clockwise, 'g': counterclockwise): R_front(Count*AngleRoll)
+			{
+				double cosAngle, sinAngle;
+				GetTurtleRotation(2,op.Count,cosAngle,sinAngle);
+
+				// compute new coordinate system vectors
+				actState.Left = cosAngle * actState.Left + sinAngle * actState.Up;
+				actState.Left.normalize();
+				actState.Up = actState.Left.crossProduct(actState.Front);
+				actState.Up.normalize();
+			}
+			break;
 
-		// scale graphic into voxel space
-		if (0 == mode)
-		{
-			// compute center
-			xMid = xMin + 0.5*(xMax - xMin);
-			yMid = yMin + 0.5*(yMax - yMin);
-			zMid = zMin + 0.5*(zMax - zMin);
-
-			/// adjust invalid values
-			if (xMax==xMin)	++xMax;
-			if (yMax==yMin)	++yMax;
-			if (zMax==zMin)	++zMax;
-
-			// border offset = 2*radius + 2*border
-			// + 1 because voxel space has a side length 1 smaller than amount of voxels at that side
-			// + 1 because of rounding issues integer <-> floating point
-			int borderOffset = 2 * (Border + static_cast<int>(radiusStart_)) + 2;
-			// compute scaling factors
-			double scaleX = static_cast<double>(SVoxelSpace::DimX-borderOffset) / (xMax-xMin);
-			double scaleY = static_cast<double>(SVoxelSpace::DimY-borderOffset) / (yMax-yMin);
-			double scaleZ = static_cast<double>(SVoxelSpace::DimZ-borderOffset) / (zMax-zMin);
-
-			// set line length to minimum scale factor
-			// so the graphic is scaled uniformly along all dimensions
-			fValue = std::min(scaleX,std::min(scaleY,scaleZ));
-			
-			// set new starting point
-			// the center point of the voxel graphic shall be identical with the center point of the voxel space
-			actState.Position.X = 0.5*static_cast<double>(SVoxelSpace::DimX-1) - fValue*xMid;
-			actState.Position.Y = 0.5*static_cast<double>(SVoxelSpace::DimY-1) - fValue*yMid;
-			actState.Position.Z = 0.5*static_cast<double>(SVoxelSpace::DimZ-1) - fValue*zMid;
-			
-			// draw sphere at start
-			DrawSphere(static_cast<int>(actState.Position.X)
-				, static_cast<int>(actState.Position.Y)
-				, static_cast<int>(actState.Position.Z)
-				, static_cast<int>(radiusStart_));
-			
-			if (PrintToConsole) std::cout << "start drawing with F-length: " << fValue
-				<< " at: " << actState.Position.X << " , " << actState.Position.Y << " , " << actState.Position.Z << std::endl;
-		}
+		case '|': // rotate around Up by 180 degrees
+			{
+				actState.Front = -actState.Front;
+				actState.Left = -actState.Left;
+			}
+			break;
 
-		++mode;
+		case '$': // orient turtle to the XZ-plane (horizontal)
+			// -> Front und Left shall span the XZ-plane
+			{
+				// Up is vertical to the XZ-plane
+				actState.Up = irr::core::vector3d<double>(0,1,0);
 
-	} // end while
+				// values to test for most numerical stable vector:
+				// the vector that is more perpendicular to Up
+				double leftValue = abs(actState.Up.dotProduct(actState.Left));
+				double frontValue = abs(actState.Up.dotProduct(actState.Front));
+
+				// compute remaining vectors
+				// normalize for numerical stability
+				if (leftValue<frontValue)	// Left is more stable
+				{
+					// compute Front
+					actState.Front = actState.Up.crossProduct(actState.Left);
+					actState.Front.normalize();
+					// then Left
+					actState.Left = actState.Front.crossProduct(actState.Up);
+					actState.Left.normalize();
+				}
+				else // Front is more stable
+				{
+					// compute Left
+					actState.Left = actState.Front.crossProduct(actState.Up);
+					actState.Left.normalize();
+					// then Front
+					actState.Front = actState.Up.crossProduct(actState.Left);
+					actState.Front.normalize();
+				}	
+			}
+			break;
+		
+		} // end switch
+		
+		// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+		// end of evaluation of drawing instruction
+		// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-	if (PrintToConsole) std::cout << std::endl;
+	} // end while
 
-	EnsureIntegrity();
+	if (PrintToConsole)
+		std::cout << segmentCount << " lines, stack depth " << TurtlePeakDepth << std::endl;
 
-} // end Draw
+	// remember what the lines belong to
+	if (!scaling_ && keepSegments_ && segmentCount <= MaxTurtleSegments)
+	{
+		TurtleExpansion = expansion_;
+		TurtleAngleYaw = angleYaw_;
+		TurtleAnglePitch = anglePitch_;
+		TurtleAngleRoll = angleRoll_;
+		TurtleSegmentsValid = true;
+	}
+}
 
 
 void DunGen::CVoxelCave::EnsureIntegrity()
@@ -715,275 +1087,604 @@ void DunGen::CVoxelCave::EnsureIntegrity()
 		std::cout << "Ensuring integrity of voxelspace ... ";
 
 	// Set all border voxels to 0
-	
-	// X planes
-	for (unsigned int i=0; i<SVoxelSpace::MinBorder; ++i)
-		for (unsigned int j=0; j<SVoxelSpace::DimY; ++j)
-			for (unsigned int k=0; k<SVoxelSpace::DimZ; ++k)
-				SetVoxel(i,j,k,0);
+	const unsigned int b = SVoxelSpace::MinBorder;
 
-	for (unsigned int i=SVoxelSpace::DimX-SVoxelSpace::MinBorder; i<SVoxelSpace::DimX; ++i)
-		for (unsigned int j=0; j<SVoxelSpace::DimY; ++j)
-			for (unsigned int k=0; k<SVoxelSpace::DimZ; ++k)
-				SetVoxel(i,j,k,0);
+	// X planes
+	ClearRegion(0,b, 0,GetDimY(), 0,GetDimZ());
+	ClearRegion(GetDimX()-b,GetDimX(), 0,GetDimY(), 0,GetDimZ());
 
 	// Y planes
-	for (unsigned int i=SVoxelSpace::MinBorder; i<SVoxelSpace::DimX-SVoxelSpace::MinBorder; ++i)
-		for (unsigned int j=0; j<SVoxelSpace::MinBorder; ++j)
-			for (unsigned int k=0; k<SVoxelSpace::DimZ; ++k)
-				SetVoxel(i,j,k,0);
-
-	for (unsigned int i=SVoxelSpace::MinBorder; i<SVoxelSpace::DimX-SVoxelSpace::MinBorder; ++i)
-		for (unsigned int j=SVoxelSpace::DimY-SVoxelSpace::MinBorder; j<SVoxelSpace::DimY; ++j)
-			for (unsigned int k=0; k<SVoxelSpace::DimZ; ++k)
-				SetVoxel(i,j,k,0);
+	ClearRegion(b,GetDimX()-b, 0,b, 0,GetDimZ());
+	ClearRegion(b,GetDimX()-b, GetDimY()-b,GetDimY(), 0,GetDimZ());
 
 	// Z planes
-	for (unsigned int i=SVoxelSpace::MinBorder; i<SVoxelSpace::DimX-SVoxelSpace::MinBorder; ++i)
-		for (unsigned int j=SVoxelSpace::MinBorder; j<SVoxelSpace::DimY-SVoxelSpace::MinBorder; ++j)
-			for (unsigned int k=0; k<SVoxelSpace::MinBorder; ++k)
-				SetVoxel(i,j,k,0);
-
-	for (unsigned int i=SVoxelSpace::MinBorder; i<SVoxelSpace::DimX-SVoxelSpace::MinBorder; ++i)
-		for (unsigned int j=SVoxelSpace::MinBorder; j<SVoxelSpace::DimY-SVoxelSpace::MinBorder; ++j)
-			for (unsigned int k=SVoxelSpace::DimZ-SVoxelSpace::MinBorder; k<SVoxelSpace::DimZ; ++k)
-				SetVoxel(i,j,k,0);
+	ClearRegion(b,GetDimX()-b, b,GetDimY()-b, 0,b);
+	ClearRegion(b,GetDimX()-b, b,GetDimY()-b, GetDimZ()-b,GetDimZ());
 
 	if (PrintToConsole)
 		std::cout << "done." << std::endl;
 }
 
+void DunGen::CVoxelCave::ClearRegion(unsigned int xBegin_, unsigned int xEnd_,
+	unsigned int yBegin_, unsigned int yEnd_, unsigned int zBegin_, unsigned int zEnd_)
+{
+	// outside of the dirty region all voxels are 0 already
+	irr::core::vector3d<unsigned int> dirtyMin, dirtyMax;
+	VoxelSpace.GetDirtyRegion(dirtyMin,dirtyMax);
+
+	xBegin_ = std::max(xBegin_,dirtyMin.X);	xEnd_ = std::min(xEnd_,dirtyMax.X);
+	yBegin_ = std::max(yBegin_,dirtyMin.Y);	yEnd_ = std::min(yEnd_,dirtyMax.Y);
+	zBegin_ = std::max(zBegin_,dirtyMin.Z);	zEnd_ = std::min(zEnd_,dirtyMax.Z);
+
+	for (unsigned int i=xBegin_; i<xEnd_; ++i)
+		for (unsigned int j=yBegin_; j<yEnd_; ++j)
+			for (unsigned int k=zBegin_; k<zEnd_; ++k)
+				SetVoxel(i,j,k,0);
+}
+
 // ======================================================
 // post processing
 // ======================================================
 
-inline bool DunGen::CVoxelCave::IsBoundaryVoxel(unsigned int x_,unsigned int y_,unsigned int z_) const
+inline unsigned int DunGen::CVoxelCave::FindRootRun(std::vector<unsigned int>& parent_, unsigned int run_)
 {
-	// a border voxel has to be a 0-voxel
-	if (0 != GetVoxel(x_,y_,z_))
-		return false;
+	// path halving
+	while (parent_[run_] != run_)
+	{
+		parent_[run_] = parent_[parent_[run_]];
+		run_ = parent_[run_];
+	}
+	return run_;
+}
+
+unsigned int DunGen::CVoxelCave::Filter(unsigned int maxFragmentSize_)
+{
+	FragmentSizes.clear();
+	FilterPeakFrontier = 0;
+
+	// older versions: flood fill of the outer hull
+	if (EFilterMode::OUTER_HULL == FilterMode)
+		return FilterOuterHull();
+
+	if (PrintToConsole) std::cout << "filter step 1: labeling connected components..." << std::endl;
+	// step 1: label the components of 0-voxels
+	std::vector<SVoxelRun> runs;
+	std::vector<unsigned int> rowRuns;
+	std::vector<unsigned int> components;
+	LabelComponents(0,runs,rowRuns,components);
+	if (runs.empty())
+		return 0;
+
+	// sizes of the components (at their first run)
+	std::vector<unsigned int> sizes(runs.size(),0);
+	for (unsigned int i=0; i<runs.size(); ++i)
+		sizes[components[i]] += runs[i].ZEnd-runs[i].ZBegin;
+
+	// the first run begins at voxel (0,0,0), which is part of the border: its component is not hovering
+	for (unsigned int i=1; i<runs.size(); ++i)
+		if (components[i] == i)
+			FragmentSizes.push_back(sizes[i]);
+	std::sort(FragmentSizes.begin(),FragmentSizes.end(),std::greater<unsigned int>());
+	FragmentSizes.insert(FragmentSizes.begin(),sizes[0]);
+
+	if (PrintToConsole) std::cout << "filter step 2: removing " << FragmentSizes.size()-1 << " hovering voxel fragments..." << std::endl;
+	// step 2: remove the small fragments (only the own slab is written)
+	const int slabThickness = static_cast<int>(CVoxelSpace::BrickSize);
+	const int slabCount = static_cast<int>(GetDimX()+CVoxelSpace::BrickSize-1) / slabThickness;
+	int numberOfVoxels = 0;
+	#pragma omp parallel for schedule(dynamic) reduction(+:numberOfVoxels)
+	for (int slab=0; slab<slabCount; ++slab)
+	{
+		const unsigned int xBegin = slab*slabThickness;
+		const unsigned int xEnd = std::min(xBegin+CVoxelSpace::BrickSize,GetDimX());
+		for (unsigned int row=xBegin*GetDimY(); row<xEnd*GetDimY(); ++row)
+			for (unsigned int i=rowRuns[row]; i<rowRuns[row+1]; ++i)
+				if (0 != components[i] && sizes[components[i]] <= maxFragmentSize_)
+				{
+					VoxelSpace.FillRow(row/GetDimY(),row%GetDimY(),runs[i].ZBegin,runs[i].ZEnd);
+					numberOfVoxels += runs[i].ZEnd-runs[i].ZBegin;
+				}
+	}
 
-	// if it has a 6-connected 1-voxel, it is a border voxel
-	if (1 == GetVoxel(x_-1,y_,z_) || 1 == GetVoxel(x_+1,y_,z_) ||
-		1 == GetVoxel(x_,y_-1,z_) || 1 == GetVoxel(x_,y_+1,z_) ||
-		1 == GetVoxel(x_,y_,z_-1) || 1 == GetVoxel(x_,y_,z_+1))
-		return true;
+	// free the memory of bricks, that have become uniform
+	VoxelSpace.Compact();
 
-	// else: no border voxel
-	return false;
+	return static_cast<unsigned int>(numberOfVoxels);
 }
 
-inline bool DunGen::CVoxelCave::IsBoundaryVoxelExtended(unsigned int x_,unsigned int y_,unsigned int z_) const
+void DunGen::CVoxelCave::ComputeComponentSizes(unsigned char occupancy_, std::vector<unsigned int>& sizes_) const
 {
-	// a border voxel has to be a 0-voxel
-	if (0 != GetVoxel(x_,y_,z_))
-		return false;
+	std::vector<SVoxelRun> runs;
+	std::vector<unsigned int> rowRuns;
+	std::vector<unsigned int> components;
+	LabelComponents(occupancy_,runs,rowRuns,components);
+
+	std::vector<unsigned int> sizes(runs.size(),0);
+	for (unsigned int i=0; i<runs.size(); ++i)
+		sizes[components[i]] += runs[i].ZEnd-runs[i].ZBegin;
+
+	sizes_.clear();
+	for (unsigned int i=0; i<runs.size(); ++i)
+		if (components[i] == i)
+			sizes_.push_back(sizes[i]);
+	std::sort(sizes_.begin(),sizes_.end(),std::greater<unsigned int>());
+}
 
-	// if it has a 6-connected 1-voxel, it is a border voxel
-	if (1 == GetVoxel(x_-1,y_,z_) || 1 == GetVoxel(x_+1,y_,z_) ||
-		1 == GetVoxel(x_,y_-1,z_) || 1 == GetVoxel(x_,y_+1,z_) ||
-		1 == GetVoxel(x_,y_,z_-1) || 1 == GetVoxel(x_,y_,z_+1))
-		return true;
+void DunGen::CVoxelCave::LabelComponents(unsigned char occupancy_,
+	std::vector<SVoxelRun>& runs_, std::vector<unsigned int>& rowRuns_, std::vector<unsigned int>& components_) const
+{
+	// the voxel space is split up into slabs along X, each one brick thick
+	const int slabThickness = static_cast<int>(CVoxelSpace::BrickSize);
+	const int slabCount = static_cast<int>(GetDimX()+CVoxelSpace::BrickSize-1) / slabThickness;
+	const unsigned int rowsPerSlab = CVoxelSpace::BrickSize*GetDimY();
+	const unsigned int rowCount = GetDimX()*GetDimY();
+
+	// step 1: collect the runs of the rows of every slab (the rows are read a brick row at once)
+	std::vector<std::vector<SVoxelRun> > slabRuns(slabCount);
+	rowRuns_.assign(rowCount+1,0);
+	#pragma omp parallel for schedule(dynamic)
+	for (int slab=0; slab<slabCount; ++slab)
+	{
+		const unsigned int rowBegin = slab*rowsPerSlab;
+		const unsigned int rowEnd = std::min(rowBegin+rowsPerSlab,rowCount);
+		for (unsigned int row=rowBegin; row<rowEnd; ++row)
+		{
+			// number of runs of the row, converted to the beginning of the row below
+			CollectRowRuns(row/GetDimY(),row%GetDimY(),occupancy_,slabRuns[slab]);
+			rowRuns_[row+1] = static_cast<unsigned int>(slabRuns[slab].size());
+		}
+	}
+
+	// concatenate the runs, the rows get global run indices
+	runs_.clear();
+	for (int slab=0; slab<slabCount; ++slab)
+	{
+		const unsigned int offset = static_cast<unsigned int>(runs_.size());
+		const unsigned int rowBegin = slab*rowsPerSlab;
+		const unsigned int rowEnd = std::min(rowBegin+rowsPerSlab,rowCount);
+		rowRuns_[rowBegin] = offset;
+		for (unsigned int row=rowBegin; row<rowEnd; ++row)
+			rowRuns_[row+1] += offset;
+		runs_.insert(runs_.end(),slabRuns[slab].begin(),slabRuns[slab].end());
+		std::vector<SVoxelRun>().swap(slabRuns[slab]);
+	}
 
-	// this is extended to 18-connected voxels
-	if (1 == GetVoxel(x_-1,y_-1,z_) || 1 == GetVoxel(x_-1,y_+1,z_) ||
-		1 == GetVoxel(x_+1,y_-1,z_) || 1 == GetVoxel(x_+1,y_+1,z_) ||
+	// every run is a component of its own
+	components_.resize(runs_.size());
+	for (unsigned int i=0; i<components_.size(); ++i)
+		components_[i] = i;
 
-		1 == GetVoxel(x_-1,y_,z_-1) || 1 == GetVoxel(x_-1,y_,z_+1) ||
-		1 == GetVoxel(x_+1,y_,z_-1) || 1 == GetVoxel(x_+1,y_,z_+1) ||
-		
-		1 == GetVoxel(x_,y_-1,z_-1) || 1 == GetVoxel(x_,y_-1,z_+1) ||
-		1 == GetVoxel(x_,y_+1,z_-1) || 1 == GetVoxel(x_,y_+1,z_+1))
-		return true;
+	// step 2: unite the runs inside of the slabs (the union-find only touches the runs of the own slab)
+	#pragma omp parallel for schedule(dynamic)
+	for (int slab=0; slab<slabCount; ++slab)
+	{
+		const unsigned int xBegin = slab*slabThickness;
+		const unsigned int xEnd = std::min(xBegin+CVoxelSpace::BrickSize,GetDimX());
+		for (unsigned int x=xBegin; x<xEnd; ++x)
+			for (unsigned int y=0; y<GetDimY(); ++y)
+			{
+				const unsigned int row = x*GetDimY()+y;
+				if (y > 0)
+					UniteRows(runs_,rowRuns_[row],rowRuns_[row+1],rowRuns_[row-1],rowRuns_[row],components_);
+				if (x > xBegin)
+					UniteRows(runs_,rowRuns_[row],rowRuns_[row+1],rowRuns_[row-GetDimY()],rowRuns_[row-GetDimY()+1],components_);
+			}
+	}
+
+	// step 3: unite the runs across the faces of the slabs
+	for (int slab=1; slab<slabCount; ++slab)
+	{
+		const unsigned int x = slab*slabThickness;
+		for (unsigned int y=0; y<GetDimY(); ++y)
+		{
+			const unsigned int row = x*GetDimY()+y;
+			UniteRows(runs_,rowRuns_[row],rowRuns_[row+1],rowRuns_[row-GetDimY()],rowRuns_[row-GetDimY()+1],components_);
+		}
+	}
 
-	// else: no border voxel
-	return false;
+	// step 4: every run points to the root of its component
+	// (roots have smaller indices, so they are resolved before)
+	for (unsigned int i=0; i<components_.size(); ++i)
+		components_[i] = components_[components_[i]];
 }
 
-inline bool DunGen::CVoxelCave::IsBoundaryVoxelBeginUpward(unsigned int x_,unsigned int y_,unsigned int z_) const
+void DunGen::CVoxelCave::CollectRowRuns(unsigned int x_, unsigned int y_, unsigned char occupancy_, std::vector<SVoxelRun>& runs_) const
 {
-	// a border voxel has to be a 0-voxel
-	if (0 != GetVoxel(x_,y_,z_))
-		return false;
+	// the run at the end of the last brick row, that may be continued
+	bool open = false;
+	SVoxelRun run;
+	for (unsigned int z=0; z<GetDimZ(); z+=CVoxelSpace::BrickSize)
+	{
+		const unsigned int bits = Classifier.GetOccupancyRowBits(x_,y_,z,occupancy_) & CVoxelClassifier::GetRowMask(z,z,GetDimZ());
 
-	// if it has a 6-connected 1-voxel, it is a border voxel
-	// check only for one voxel, for faster test
-	if (1 == GetVoxel(x_+1,y_,z_))
-		return true;
+		// uniform brick row: continue or begin a run over the whole brick row
+		if (CVoxelClassifier::RowMask == bits)
+		{
+			if (!open)
+			{
+				run.ZBegin = z;
+				open = true;
+			}
+			continue;
+		}
 
-	// else: no border voxel
-	return false;
+		for (unsigned int i=0; i<CVoxelSpace::BrickSize; ++i)
+		{
+			const bool set = 0 != ((bits >> i) & 1);
+			if (set && !open)
+			{
+				run.ZBegin = z+i;
+				open = true;
+			}
+			else if (!set && open)
+			{
+				run.ZEnd = z+i;
+				runs_.push_back(run);
+				open = false;
+			}
+		}
+	}
+	if (open)
+	{
+		run.ZEnd = GetDimZ();
+		runs_.push_back(run);
+	}
 }
 
-inline bool DunGen::CVoxelCave::IsBoundaryVoxelBeginDownward(unsigned int x_,unsigned int y_,unsigned int z_) const
+void DunGen::CVoxelCave::UniteRows(const std::vector<SVoxelRun>& runs_, unsigned int row0Begin_, unsigned int row0End_,
+	unsigned int row1Begin_, unsigned int row1End_, std::vector<unsigned int>& parent_)
 {
-	// a border voxel has to be a 0-voxel
-	if (0 != GetVoxel(x_,y_,z_))
-		return false;
-
-	// if it has a 6-connected 1-voxel, it is a border voxel
-	// check only for one voxel, for faster test
-	if (1 == GetVoxel(x_-1,y_,z_))
-		return true;
+	// both rows are sorted along Z: walk along the overlapping runs
+	unsigned int i = row0Begin_;
+	unsigned int j = row1Begin_;
+	while (i < row0End_ && j < row1End_)
+	{
+		if (runs_[i].ZBegin < runs_[j].ZEnd && runs_[j].ZBegin < runs_[i].ZEnd)
+		{
+			// unite: the root with the smaller index becomes the root of both
+			const unsigned int root0 = FindRootRun(parent_,i);
+			const unsigned int root1 = FindRootRun(parent_,j);
+			if (root0 < root1)
+				parent_[root1] = root0;
+			else if (root1 < root0)
+				parent_[root0] = root1;
+		}
 
-	// else: no border voxel
-	return false;
+		// continue with the run, that ends first
+		if (runs_[i].ZEnd < runs_[j].ZEnd)
+			++i;
+		else
+			++j;
+	}
 }
 
-unsigned int DunGen::CVoxelCave::Filter()
+unsigned int DunGen::CVoxelCave::FilterOuterHull()
 {
 	// remove all 0-voxels that are not part of the outer connected component of 0-voxels
 
 	unsigned int lastXofSearch = UINT_MAX;
+	FilterPeakFrontier = 0;
 
 	// step 1: compute and mark outer hull
 	if (PrintToConsole) std::cout << "filter step 1: marking outer hull..." << std::endl;
 	SVoxelToDraw startVoxel;
-	// find start voxel for outer hull
-	for (unsigned int i=MinBorderFilter; i<SVoxelSpace::DimX-MinBorderFilter; ++i)
-		for (unsigned int j=MinBorderFilter; j<SVoxelSpace::DimY-MinBorderFilter; ++j)
-			for (unsigned int k=MinBorderFilter; k<SVoxelSpace::DimZ-MinBorderFilter; ++k)
-				if (IsBoundaryVoxelBeginUpward(i,j,k))
+	const unsigned int zMin = MinBorderFilter;
+	const unsigned int zMax = GetDimZ()-MinBorderFilter;
+	unsigned int free, stone, neighborFree, neighborStone;
+	// find start voxel for outer hull: the first 0-voxel with a 1-voxel in front of it (in positive X direction)
+	for (unsigned int i=MinBorderFilter; i<GetDimX()-MinBorderFilter; ++i)
+		for (unsigned int j=MinBorderFilter; j<GetDimY()-MinBorderFilter; ++j)
+			for (unsigned int z=zMin & ~(CVoxelSpace::BrickSize-1); z<zMax; z+=CVoxelSpace::BrickSize)
+			{
+				// skip brick rows without 0-voxels or without 1-voxels in front of them
+				const unsigned int zBegin = z > zMin ? z : zMin;
+				if (CVoxelSpace::EBrickState::UNIFORM_1 == VoxelSpace.GetBrickState(i,j,zBegin)
+					|| CVoxelSpace::EBrickState::UNIFORM_0 == VoxelSpace.GetBrickState(i+1,j,zBegin))
+					continue;
+
+				Classifier.GetValueRowBits(i,j,z,free,stone);
+				Classifier.GetValueRowBits(i+1,j,z,neighborFree,neighborStone);
+				const unsigned int bits = stone & neighborFree & CVoxelClassifier::GetRowMask(z,zBegin,zMax);
+				if (0 != bits)
 				{
 					// store voxel
-					startVoxel.X=i; startVoxel.Y=j; startVoxel.Z=k;
+					startVoxel.X=i; startVoxel.Y=j; startVoxel.Z=z+CVoxelClassifier::GetLowestBit(bits);
 					lastXofSearch = i;
 					// break search
-					i = SVoxelSpace::DimX; j = SVoxelSpace::DimY; break;
+					i = GetDimX(); j = GetDimY(); break;
 				}
+			}
 	
-	if (lastXofSearch >= SVoxelSpace::DimX-MinBorderFilter)
+	if (lastXofSearch >= GetDimX()-MinBorderFilter)
 	{
 		if (PrintToConsole) std::cout << "filtering did not find outer hull -> aborting." << std::endl;
 		return 0;
 	}
 
-	// queue for for breadth-first search over border voxels
-	// (depth-first search (with stack) not recommendable, because "graph" is not acyclic -> extreme high memory usage (tested))
-	std::queue<SVoxelToDraw> queueVoxel;
-	SVoxelToDraw actVoxel;
-	queueVoxel.push(startVoxel);
+	MarkOuterHull(startVoxel);
 
-	// mark outer hull
-	while (!queueVoxel.empty())
-	{
-		// take voxel from queue
-		actVoxel = queueVoxel.front();
-		queueVoxel.pop();
+	// step 2: remove hovering voxel fragments
+	if (PrintToConsole) std::cout << "filter step 2: removing hovering voxel fragments..." << std::endl;
+	unsigned int numberOfVoxels = 0;
+	// search for remaining border voxels (they belong to hovering fragments): 0-voxels with a 1-voxel behind them (in negative X direction),
+	// the rows of x-1 have been cleared before, so the removal continues along X
+	for (unsigned int i=lastXofSearch+2; i<GetDimX()-MinBorderFilter; ++i)
+		for (unsigned int j=MinBorderFilter; j<GetDimY()-MinBorderFilter; ++j)
+			for (unsigned int z=zMin & ~(CVoxelSpace::BrickSize-1); z<zMax; z+=CVoxelSpace::BrickSize)
+			{
+				// skip brick rows without 0-voxels or without 1-voxels behind them
+				const unsigned int zBegin = z > zMin ? z : zMin;
+				if (CVoxelSpace::EBrickState::UNIFORM_1 == VoxelSpace.GetBrickState(i,j,zBegin)
+					|| CVoxelSpace::EBrickState::UNIFORM_0 == VoxelSpace.GetBrickState(i-1,j,zBegin))
+					continue;
+
+				Classifier.GetValueRowBits(i,j,z,free,stone);
+				Classifier.GetValueRowBits(i-1,j,z,neighborFree,neighborStone);
+				unsigned int bits = stone & neighborFree & CVoxelClassifier::GetRowMask(z,zBegin,zMax);
+
+				// count removed voxels
+				numberOfVoxels += CVoxelClassifier::CountBits(bits);
+				// clear voxels
+				for (; 0 != bits; bits &= bits-1)
+					SetVoxel(i,j,z+CVoxelClassifier::GetLowestBit(bits),1);
+			}
+
+	// step 3: restore original marking of outer hull
+	if (PrintToConsole) std::cout << "filter step 3: restore original marking of outer hull..." << std::endl;
+
+	for (unsigned int i=lastXofSearch; i<GetDimX()-MinBorderFilter; ++i)
+		for (unsigned int j=MinBorderFilter; j<GetDimY()-MinBorderFilter; ++j)
+			for (unsigned int k=MinBorderFilter; k<GetDimZ()-MinBorderFilter; ++k)
+			{
+				// skip bricks without marks
+				if (!VoxelSpace.HasMarks(i,j,k))
+				{
+					k = GetBrickRowEnd(k,GetDimZ()-MinBorderFilter)-1;
+					continue;
+				}
+
+				if (HelperVoxel == GetVoxel(i,j,k))
+					SetVoxel(i,j,k,0);		// original marking was 0
+			}
+
+	// free the memory of the helper marks and of bricks, that have become uniform
+	VoxelSpace.Compact();
+
+	return numberOfVoxels;
+}
 
-		// check all 6-connected neighbor voxels
-		if (IsBoundaryVoxelExtended(actVoxel.X-1,actVoxel.Y,actVoxel.Z))
+void DunGen::CVoxelCave::MarkOuterHull(const SVoxelToDraw& startVoxel_)
+{
+	// the 4 rows next to a row (the neighbors along Z are part of the run)
+	static const int neighborRows[4][2] = {{-1,0},{1,0},{0,-1},{0,1}};
+	const unsigned int brickMask = CVoxelSpace::BrickSize-1;
+
+	// queue of seed voxels for breadth-first search over runs: one per run, that has been found next to a marked run,
+	// so the queue only holds the runs of the front of the search
+	// (a run is marked completely or not at all, so marked voxels fail the border voxel test and seeds of marked runs are skipped)
+	std::queue<SVoxelToDraw> seeds;
+	seeds.push(startVoxel_);
+	FilterPeakFrontier = 1;
+
+	SVoxelToDraw seed;
+	while (!seeds.empty())
+	{
+		const SVoxelToDraw actVoxel = seeds.front();
+		seeds.pop();
+		unsigned int chunk = actVoxel.Z & ~brickMask;
+		if (0 == Classifier.GetBoundaryRowBitsExtended(actVoxel.X,actVoxel.Y,chunk,1u << (actVoxel.Z & brickMask)))
+			continue;
+
+		// extend the run along Z, the border voxels are classified a brick row at once
+		unsigned int bits = Classifier.GetBoundaryRowBitsExtended(actVoxel.X,actVoxel.Y,chunk,CVoxelClassifier::RowMask);
+		unsigned int zBegin = actVoxel.Z;
+		while (zBegin > 0)
 		{
-			// create new voxel
-			SVoxelToDraw newVoxel;
-			newVoxel.X = actVoxel.X-1; newVoxel.Y = actVoxel.Y; newVoxel.Z = actVoxel.Z;
-			// store into queue
-			queueVoxel.push(newVoxel);
-			// then mark voxel
-			SetVoxel(newVoxel.X,newVoxel.Y,newVoxel.Z,HelperVoxel);
+			if (((zBegin-1) & ~brickMask) != chunk)
+			{
+				chunk = (zBegin-1) & ~brickMask;
+				bits = Classifier.GetBoundaryRowBitsExtended(actVoxel.X,actVoxel.Y,chunk,CVoxelClassifier::RowMask);
+			}
+			if (0 == ((bits >> ((zBegin-1) & brickMask)) & 1))
+				break;
+			--zBegin;
 		}
-		if (IsBoundaryVoxelExtended(actVoxel.X+1,actVoxel.Y,actVoxel.Z))
+		unsigned int zEnd = actVoxel.Z+1;
+		while (zEnd < GetDimZ())
 		{
-			// create new voxel
-			SVoxelToDraw newVoxel;
-			newVoxel.X = actVoxel.X+1; newVoxel.Y = actVoxel.Y; newVoxel.Z = actVoxel.Z;
-			// store into queue
-			queueVoxel.push(newVoxel);
-			// then mark voxel
-			SetVoxel(newVoxel.X,newVoxel.Y,newVoxel.Z,HelperVoxel);
+			if ((zEnd & ~brickMask) != chunk)
+			{
+				chunk = zEnd & ~brickMask;
+				bits = Classifier.GetBoundaryRowBitsExtended(actVoxel.X,actVoxel.Y,chunk,CVoxelClassifier::RowMask);
+			}
+			if (0 == ((bits >> (zEnd & brickMask)) & 1))
+				break;
+			++zEnd;
 		}
-		if (IsBoundaryVoxelExtended(actVoxel.X,actVoxel.Y-1,actVoxel.Z))
+
+		// mark the run
+		for (unsigned int z=zBegin; z<zEnd; ++z)
+			SetVoxel(actVoxel.X,actVoxel.Y,z,HelperVoxel);
+
+		// store one seed for every run of unmarked border voxels in the neighbor rows, that touches the run
+		for (unsigned int n=0; n<4; ++n)
 		{
-			// create new voxel
-			SVoxelToDraw newVoxel;
-			newVoxel.X = actVoxel.X; newVoxel.Y = actVoxel.Y-1; newVoxel.Z = actVoxel.Z;
-			// store into queue
-			queueVoxel.push(newVoxel);
-			// then mark voxel
-			SetVoxel(newVoxel.X,newVoxel.Y,newVoxel.Z,HelperVoxel);
+			seed.X = actVoxel.X+neighborRows[n][0];
+			seed.Y = actVoxel.Y+neighborRows[n][1];
+			bool inRun = false;
+			for (unsigned int z=zBegin; z<zEnd; ++z)
+			{
+				// classify the part of the brick row next to the run
+				if (z == zBegin || 0 == (z & brickMask))
+				{
+					const unsigned int mask = CVoxelClassifier::GetRowMask(z & ~brickMask,z,zEnd);
+					bits = Classifier.GetBoundaryRowBitsExtended(seed.X,seed.Y,z & ~brickMask,mask);
+				}
+				const bool boundary = 0 != ((bits >> (z & brickMask)) & 1);
+				if (boundary && !inRun)
+				{
+					seed.Z = z;
+					seeds.push(seed);
+				}
+				inRun = boundary;
+			}
 		}
-		if (IsBoundaryVoxelExtended(actVoxel.X,actVoxel.Y+1,actVoxel.Z))
+
+		if (seeds.size() > FilterPeakFrontier)
+			FilterPeakFrontier = static_cast<unsigned int>(seeds.size());
+	}
+}
+
+inline void DunGen::CVoxelCave::GetErosionSlab(int slab_, unsigned int& xBegin_, unsigned int& xEnd_) const
+{
+	const unsigned int xMin = SVoxelSpace::MinBorder;
+	const unsigned int xMax = GetDimX()-SVoxelSpace::MinBorder;
+	xBegin_ = std::max(static_cast<unsigned int>(slab_)*CVoxelSpace::BrickSize, xMin);
+	xEnd_ = std::min(static_cast<unsigned int>(slab_+1)*CVoxelSpace::BrickSize, xMax);
+}
+
+void DunGen::CVoxelCave::Erode(double erosionLikelihood_, unsigned int iterations_)
+{
+	if (0 == iterations_)
+		return;
+
+	// the voxel space is split up into slabs along X, each one brick thick (slabs share no brick)
+	const int slabCount = static_cast<int>(GetDimX()+CVoxelSpace::BrickSize-1) / static_cast<int>(CVoxelSpace::BrickSize);
+	// border voxels and eroded voxels per slab, in x/y/z order
+	std::vector<std::vector<SVoxelToDraw> > boundary(slabCount);
+	std::vector<std::vector<SVoxelToDraw> > eroded(slabCount);
+
+	if (PrintToConsole) std::cout << "erode step 1: search border voxels..." << std::endl;
+	// step 1: search the border voxels (read only)
+	#pragma omp parallel for schedule(dynamic)
+	for (int slab=0; slab<slabCount; ++slab)
+	{
+		unsigned int xBegin, xEnd;
+		GetErosionSlab(slab,xBegin,xEnd);
+		CollectBoundaryVoxels(xBegin,xEnd,boundary[slab]);
+	}
+
+	for (unsigned int iteration=0; iteration<iterations_; ++iteration)
+	{
+		// the hash generator gets another stream for every erosion of the same cave
+		const unsigned int stream = ErosionCount++;
+
+		if (PrintToConsole) std::cout << "erode step 2: erosion " << iteration+1 << " of " << iterations_ << "..." << std::endl;
+		// step 2a: select the voxels to erode
+		if (RandomGenerator->IsLegacyMode())
 		{
-			// create new voxel
-			SVoxelToDraw newVoxel;
-			newVoxel.X = actVoxel.X; newVoxel.Y = actVoxel.Y+1; newVoxel.Z = actVoxel.Z;
-			// store into queue
-			queueVoxel.push(newVoxel);
-			// then mark voxel
-			SetVoxel(newVoxel.X,newVoxel.Y,newVoxel.Z,HelperVoxel);
+			// the linear congruential generator has to be drawn from in strict x/y/z order
+			for (int slab=0; slab<slabCount; ++slab)
+				SelectErodedVoxels(boundary[slab],eroded[slab],erosionLikelihood_,stream);
 		}
-		if (IsBoundaryVoxelExtended(actVoxel.X,actVoxel.Y,actVoxel.Z-1))
+		else
 		{
-			// create new voxel
-			SVoxelToDraw newVoxel;
-			newVoxel.X = actVoxel.X; newVoxel.Y = actVoxel.Y; newVoxel.Z = actVoxel.Z-1;
-			// store into queue
-			queueVoxel.push(newVoxel);
-			// dann Voxel  markieren
-			SetVoxel(newVoxel.X,newVoxel.Y,newVoxel.Z,HelperVoxel);
+			// the hash generator only depends on the voxel coordinates
+			#pragma omp parallel for schedule(dynamic)
+			for (int slab=0; slab<slabCount; ++slab)
+				SelectErodedVoxels(boundary[slab],eroded[slab],erosionLikelihood_,stream);
 		}
-		if (IsBoundaryVoxelExtended(actVoxel.X,actVoxel.Y,actVoxel.Z+1))
+
+		// step 2b: delete the selected voxels (only the own slab is written)
+		#pragma omp parallel for schedule(dynamic)
+		for (int slab=0; slab<slabCount; ++slab)
+			for (unsigned int i=0; i<eroded[slab].size(); ++i)
+				SetVoxel(eroded[slab][i].X,eroded[slab][i].Y,eroded[slab][i].Z,1);
+
+		// step 2c: the remaining border voxels stay border voxels (voxels only change from 0 to 1),
+		// the 0-voxels next to the eroded voxels become border voxels (read only)
+		if (iteration+1 < iterations_)
 		{
-			// create new voxel
-			SVoxelToDraw newVoxel;
-			newVoxel.X = actVoxel.X; newVoxel.Y = actVoxel.Y; newVoxel.Z = actVoxel.Z+1;
-			// store into queue
-			queueVoxel.push(newVoxel);
-			// then mark voxel
-			SetVoxel(newVoxel.X,newVoxel.Y,newVoxel.Z,HelperVoxel);
+			#pragma omp parallel for schedule(dynamic)
+			for (int slab=0; slab<slabCount; ++slab)
+				AddExposedVoxels(eroded,slab,boundary[slab]);
 		}
 	}
 
-	// step 2: remove hovering voxel fragments
-	if (PrintToConsole) std::cout << "filter step 2: removing hovering voxel fragments..." << std::endl;
-	unsigned int numberOfVoxels = 0;
-	// search for remaining border voxels (they belong to hovering fragments)
-	for (unsigned int i=lastXofSearch+2; i<SVoxelSpace::DimX-MinBorderFilter; ++i)
-		for (unsigned int j=MinBorderFilter; j<SVoxelSpace::DimY-MinBorderFilter; ++j)
-			for (unsigned int k=MinBorderFilter; k<SVoxelSpace::DimZ-MinBorderFilter; ++k)
-				if (IsBoundaryVoxelBeginDownward(i,j,k))
-				{
-					// count removed voxels
-					++numberOfVoxels;
-					// clear voxel
-					SetVoxel(i,j,k,1);
-				}
-
-	// step 3: restore original marking of outer hull
-	if (PrintToConsole) std::cout << "filter step 3: restore original marking of outer hull..." << std::endl;
+	// free the memory of bricks, that have become uniform
+	VoxelSpace.Compact();
+}
 
-	for (unsigned int i=lastXofSearch; i<SVoxelSpace::DimX-MinBorderFilter; ++i)
-		for (unsigned int j=MinBorderFilter; j<SVoxelSpace::DimY-MinBorderFilter; ++j)
-			for (unsigned int k=MinBorderFilter; k<SVoxelSpace::DimZ-MinBorderFilter; ++k)
-				if (HelperVoxel == GetVoxel(i,j,k))
-					SetVoxel(i,j,k,0);		// original marking was 0
+void DunGen::CVoxelCave::CollectBoundaryVoxels(unsigned int xBegin_, unsigned int xEnd_, std::vector<SVoxelToDraw>& boundary_) const
+{
+	const unsigned int zMin = SVoxelSpace::MinBorder;
+	const unsigned int zMax = GetDimZ()-SVoxelSpace::MinBorder;
 
-	return numberOfVoxels;
+	SVoxelToDraw voxel;
+	for (unsigned int i=xBegin_; i<xEnd_; ++i)
+	{
+		for (unsigned int j=SVoxelSpace::MinBorder; j<GetDimY()-SVoxelSpace::MinBorder; ++j)
+			for (unsigned int z=zMin & ~(CVoxelSpace::BrickSize-1); z<zMax; z+=CVoxelSpace::BrickSize)
+			{
+				// skip brick rows without junctions
+				const unsigned int zBegin = z > zMin ? z : zMin;
+				const unsigned int zEnd = GetBrickRowEnd(zBegin,zMax);
+				if (IsRowWithoutJunction(i,j,zBegin,zEnd))
+					continue;
+
+				// the border voxels of the brick row, in z order
+				unsigned int bits = Classifier.GetBoundaryRowBits(i,j,z,CVoxelClassifier::GetRowMask(z,zBegin,zEnd));
+				for (; 0 != bits; bits &= bits-1)
+				{
+					voxel.X = i;
+					voxel.Y = j;
+					voxel.Z = z+CVoxelClassifier::GetLowestBit(bits);
+					boundary_.push_back(voxel);
+				}
+			}
+	}
 }
 
-void DunGen::CVoxelCave::Erode(double erosionLikelihood_)
+void DunGen::CVoxelCave::SelectErodedVoxels(std::vector<SVoxelToDraw>& boundary_, std::vector<SVoxelToDraw>& eroded_,
+	double erosionLikelihood_, unsigned int stream_) const
 {
-	if (PrintToConsole) std::cout << "erode step 1: mark voxels to erode..." << std::endl;
-	// step 1: mark voxels to erode
-	for (unsigned int i=SVoxelSpace::MinBorder; i<SVoxelSpace::DimX-SVoxelSpace::MinBorder; ++i)
+	const bool legacyMode = RandomGenerator->IsLegacyMode();
+	const unsigned int seed = RandomGenerator->GetHashSeed();
+
+	eroded_.clear();
+	unsigned int kept = 0;
+	for (unsigned int i=0; i<boundary_.size(); ++i)
 	{
-		for (unsigned int j=SVoxelSpace::MinBorder; j<SVoxelSpace::DimY-SVoxelSpace::MinBorder; ++j)
-			for (unsigned int k=SVoxelSpace::MinBorder; k<SVoxelSpace::DimZ-SVoxelSpace::MinBorder; ++k)
-				if (IsBoundaryVoxel(i,j,k))
-					if (RandomGenerator->GetRandomNumber_01()<=erosionLikelihood_)
-						SetVoxel(i,j,k,HelperVoxel);
+		const SVoxelToDraw& voxel = boundary_[i];
+		const double random = legacyMode ? RandomGenerator->GetRandomNumber_01()
+			: RandomGenerator->GetHashNumber_01(seed,voxel.X,voxel.Y,voxel.Z,stream_);
+		if (random<=erosionLikelihood_)
+			eroded_.push_back(voxel);
+		else
+			boundary_[kept++] = voxel;
 	}
-
-	if (PrintToConsole) std::cout << "erode step 2: delete marked voxels..." << std::endl;
-	// step 2: delete marked voxels
-	for (unsigned int i=SVoxelSpace::MinBorder; i<SVoxelSpace::DimX-SVoxelSpace::MinBorder; ++i)
-		for (unsigned int j=SVoxelSpace::MinBorder; j<SVoxelSpace::DimY-SVoxelSpace::MinBorder; ++j)
-			for (unsigned int k=SVoxelSpace::MinBorder; k<SVoxelSpace::DimZ-SVoxelSpace::MinBorder; ++k)
-				if (HelperVoxel == GetVoxel(i,j,k))
-					SetVoxel(i,j,k,1);
+	boundary_.resize(kept);
 }
 
-unsigned char (&DunGen::CVoxelCave::GetVoxelSpace())[SVoxelSpace::DimX][SVoxelSpace::DimY][SVoxelSpace::DimZ]
+void DunGen::CVoxelCave::AddExposedVoxels(const std::vector<std::vector<SVoxelToDraw> >& eroded_, int slab_, std::vector<SVoxelToDraw>& boundary_) const
 {
-	return Voxel;
-}
\ No newline at end of file
+	static const int neighbors[6][3] = {{-1,0,0},{1,0,0},{0,-1,0},{0,1,0},{0,0,-1},{0,0,1}};
+
+	unsigned int xBegin, xEnd;
+	GetErosionSlab(slab_,xBegin,xEnd);
+	const int yMin = SVoxelSpace::MinBorder;
+	const int yMax = GetDimY()-SVoxelSpace::MinBorder;
+	const int zMin = SVoxelSpace::MinBorder;
+	const int zMax = GetDimZ()-SVoxelSpace::MinBorder;
+
+	// the eroded voxels of the neighbor slabs can expose voxels at the faces of the slab
+	const unsigned int keptCount = boundary_.size();
+	SVoxelToDraw voxel;
+	for (int slab=std::max(slab_-1,0); slab<=std::min(slab_+1,static_cast<int>(eroded_.size())-1); ++slab)
+		for (unsigned int i=0; i<eroded_[slab].size(); ++i)
+			for (unsigned int n=0; n<6; ++n)
+			{
+				voxel.X = eroded_[slab][i].X + neighbors[n][0];
+				voxel.Y = eroded_[slab][i].Y + neighbors[n][1];
+				voxel.Z = eroded_[slab][i].Z + neighbors[n][2];
+				if (voxel.X >= static_cast<int>(xBegin) && voxel.X < static_cast<int>(xEnd)
+					&& voxel.Y >= yMin && voxel.Y < yMax && voxel.Z >= zMin && voxel.Z < zMax
+					&& 0 == GetVoxel(voxel.X,voxel.Y,voxel.Z))
+					boundary_.push_back(voxel);
+			}
+
+	// merge them into the (sorted) remaining border voxels, without duplicates
+	std::sort(boundary_.begin()+keptCount,boundary_.end());
+	std::inplace_merge(boundary_.begin(),boundary_.begin()+keptCount,boundary_.end());
+	boundary_.erase(std::unique(boundary_.begin(),boundary_.end()),boundary_.end());
+}
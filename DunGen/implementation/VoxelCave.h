@@ -6,6 +6,9 @@
 #define VOXELCAVE_H
 
 #include "interface/VoxelCaveCommon.h"
+#include "LSystem.h"
+#include "VoxelSpace.h"
+#include "VoxelClassifier.h"
 #include <irrlicht.h>
 #include <string>
 #include <vector>
@@ -34,8 +37,57 @@ namespace DunGen
 			/// local coordinate system: up vector
 			irr::core::vector3d<double> Up;
 
-			/// drawing radius in voxels
-			double Radius;	
+			/// number of radius reductions ('!'), the radius itself is computed when the graphic is scaled into the voxel space
+			unsigned int Reductions;
+		};
+
+		/// line of the turtle graphic in unscaled turtle coordinates (F-length 1, starting at the origin)
+		struct STurtleSegment
+		{
+			/// start point
+			irr::core::vector3d<double> Start;
+			/// end point
+			irr::core::vector3d<double> End;
+			/// number of radius reductions ('!') of the line
+			unsigned int Reductions;
+		};
+
+		/// scaling of the unscaled lines into the voxel space
+		struct STurtleScaling
+		{
+			/// position of the origin
+			irr::core::vector3d<double> Start;
+			/// F-length
+			double FValue;
+			/// drawing radius after n radius reductions
+			std::vector<int> Radii;
+		};
+
+		/// instruction of the turtle graphic: a run of symbols merged into one operation, symbols without meaning for the turtle are skipped
+		struct STurtleOp
+		{
+			/// instruction: 'F', '!', '+' (yaw), 'u' (pitch), 'z' (roll), '|', '$', '[', ']', 0 = end of the derivation
+			char Instruction;
+			/// number of repetitions (rotations: net number, negative for '-', 'o', 'g')
+			int Count;
+		};
+
+		/// maximum number of unscaled lines kept for the next Draw(), bigger graphics are interpreted twice instead
+		static const unsigned int MaxTurtleSegments = 1000000;
+		/// maximum number of turtle states allocated in advance (by the predicted stack depth)
+		static const unsigned int MaxReservedTurtleStates = 65536;
+		/// maximum number of merged rotations (Count), whose sinus and cosinus are tabulated per interpretation
+		static const int MaxTabulatedRotation = 16;
+
+		/// geometric primitive of the turtle graphic: capsule from start to end with radius (a sphere, if start == end)
+		struct SPrimitive
+		{
+			/// start point
+			int XStart, YStart, ZStart;
+			/// end point
+			int XEnd, YEnd, ZEnd;
+			/// radius
+			int Radius;
 		};
 
 		/// voxel coordinates
@@ -43,6 +95,26 @@ namespace DunGen
 		{
 			/// coordinates
 			int X, Y, Z;
+
+			/// order of the voxel space passes: X, then Y, then Z
+			bool operator<(const SVoxelToDraw& other_) const
+			{
+				if (X != other_.X) return X < other_.X;
+				if (Y != other_.Y) return Y < other_.Y;
+				return Z < other_.Z;
+			}
+			/// equal coordinates
+			bool operator==(const SVoxelToDraw& other_) const
+			{
+				return X == other_.X && Y == other_.Y && Z == other_.Z;
+			}
+		};
+
+		/// run of voxels along Z (connected component labeling)
+		struct SVoxelRun
+		{
+			/// Z range [ZBegin,ZEnd)
+			unsigned int ZBegin, ZEnd;
 		};
 
 		/// the value of a helper voxel
@@ -57,78 +129,206 @@ namespace DunGen
 
 	public:
 		/// constructor
-		__declspec(noinline) CVoxelCave(const CRandomGenerator* randomGenerator_);
+		CVoxelCave(const CRandomGenerator* randomGenerator_);
 		// destructor
 		~CVoxelCave();
 
-		/// draw turtle graphic in voxel space
-		void Draw(std::string instructions_, double angleYaw_, double anglePitch_, double angleRoll_, double radiusStart_, double radiusFactor_, double radiusDecrement_);
+		/// draw turtle graphic of the derivation in voxel space (the interpreted graphic is reused, if only dimensions, border or radii have changed),
+		/// with a prediction (optional) the turtle stack is allocated in advance and the lines are not recorded, if too many are predicted:
+		/// the graphic is interpreted twice then, for its exact bounding box and for scaling the lines
+		void Draw(CLSystemExpansion& expansion_, const CLSystem::STurtlePrediction* prediction_, double angleYaw_, double anglePitch_, double angleRoll_, double radiusStart_, double radiusFactor_, double radiusDecrement_);
 
-		/// erode 1 voxel deep
+		/// erode 1 voxel deep per iteration
 		///
 		/// ErosionLikelihood is the likelihood for the erosion of a voxel:
 		/// 1 ... every voxel is eroded, 0 ... no voxel is eroded
-		void Erode(double erosionLikelihood_);
+		///
+		/// the border voxels are searched once, further iterations only update them next to the eroded voxels,
+		/// the result is identical to calling Erode() iterations_ times with 1 iteration
+		///
+		/// the voxel space is eroded in parallel (split up into slabs along X),
+		/// with the hash generator the result is identical for any number of threads (legacy mode draws the random numbers on one thread)
+		void Erode(double erosionLikelihood_, unsigned int iterations_);
 
 		/// remove hovering fragments
-		unsigned int Filter();
+		///
+		/// the 0-voxels are split up into 6-connected components (connected component labeling in parallel),
+		/// the component connected to the border of the voxel space is kept, the other components (hovering fragments)
+		/// are removed, if they have at most maxFragmentSize_ voxels (UINT_MAX: all fragments are removed)
+		///
+		/// in filter mode OUTER_HULL, all fragments are removed as in older versions:
+		/// the outer hull is marked by a flood fill and the unmarked 0-voxels behind 1-voxels are removed along X
+		/// \returns the number of removed voxels
+		unsigned int Filter(unsigned int maxFragmentSize_);
+
+		/// returns the sizes of the 0-voxel components found by the last Filter() in voxels:
+		/// the component connected to the border first, then the hovering fragments by decreasing size (empty in filter mode OUTER_HULL)
+		const std::vector<unsigned int>& GetFragmentSizes() const {return FragmentSizes;}
+
+		/// computes the sizes of the 6-connected components of the voxels with the given occupancy (0 = stone, 1 = free space) by decreasing size
+		void ComputeComponentSizes(unsigned char occupancy_, std::vector<unsigned int>& sizes_) const;
+
+		/// returns the maximum number of runs waiting for the flood fill of the outer hull in the last Filter() (filter mode OUTER_HULL)
+		unsigned int GetFilterPeakFrontier() const {return FilterPeakFrontier;}
 
 		/// set the minimum voxel space border (this is always 0 = stone, cannot be smaller than 3)
 		void SetBorder(unsigned int border_);
 
+		/// set the dimensions of the voxel space (clamped to [SVoxelSpace::MinDim,SVoxelSpace::MaxDim])
+		void SetDimensions(unsigned int dimX_, unsigned int dimY_, unsigned int dimZ_);
+
+		/// get X dimension of the voxel space
+		unsigned int GetDimX() const {return VoxelSpace.GetDimX();}
+		/// get Y dimension of the voxel space
+		unsigned int GetDimY() const {return VoxelSpace.GetDimY();}
+		/// get Z dimension of the voxel space
+		unsigned int GetDimZ() const {return VoxelSpace.GetDimZ();}
+
 		/// set the minimal draw radius for turle graphic
 		void SetMinDrawRadius(unsigned int minDrawRadius_);
 		
 		/// estimate number of triangles, that are needed to model the voxel cave as mesh
-		unsigned int EstimateMeshComplexity() const;
+		///
+		/// the 0<->1 junctions are counted per brick and kept together with their sum, only the bricks, that have been written to since the last estimate
+		/// (and the bricks behind them), are counted again
+		///
+		/// not thread-safe: the kept counts are updated
+		unsigned int EstimateMeshComplexity();
 
 		/// sets if status reports should be printed to the console
 		void SetPrintToConsole(bool enabled_);
 
+		/// sets if Draw() also computes a quantized distance field near the cave surface (used for vertex placement by the mesh)
+		void SetDistanceFieldEnabled(bool enabled_);
+
+		/// sets how Filter() removes hovering fragments
+		void SetFilterMode(EFilterMode::Enum filterMode_);
+
+		/// returns true, if the last Draw() computed a distance field
+		bool HasDistanceField() const {return DistanceFieldValid;}
+
+		/// gets the signed distance of a voxel to the cave surface in 1/CVoxelSpace::DistanceScale voxels (positive in free space)
+		int GetDistance(unsigned int x_, unsigned int y_, unsigned int z_) const {return VoxelSpace.GetDistance(x_,y_,z_);}
+
+		/// returns the number of bytes of the voxel space, that have been touched for clearing at the beginning of the last Draw()
+		unsigned int GetClearedBytes() const {return VoxelSpace.GetClearedBytes();}
+
+		/// returns the maximum depth of the turtle stack ('[') of the last interpretation of the turtle graphic
+		unsigned int GetTurtlePeakDepth() const {return TurtlePeakDepth;}
+
 		/// sets a voxel to a specific value
 		inline void SetVoxel(unsigned int x_, unsigned int y_, unsigned int z_, unsigned char value_);
 
 		/// gets the value of a voxel
 		inline unsigned char GetVoxel(unsigned int x_, unsigned int y_, unsigned int z_) const;
 
-		/// Provides direct access to voxel space.
-		unsigned char (&GetVoxelSpace())[SVoxelSpace::DimX][SVoxelSpace::DimY][SVoxelSpace::DimZ];
+		/// returns the end (exclusive) of the brick row beginning at z_, limited to zEnd_
+		inline unsigned int GetBrickRowEnd(unsigned int z_, unsigned int zEnd_) const;
+
+		/// tests if the voxel row [z_,zEnd_) (inside one brick) and all its 6-connected neighbors have the same uniform occupancy,
+		/// so the row has no 0<->1 junction and can be skipped by full voxel space passes
+		inline bool IsRowWithoutJunction(unsigned int x_, unsigned int y_, unsigned int z_, unsigned int zEnd_) const;
 
 	private:
-		/// geometric primitive: cylinder
-		void DrawCylinder(int xs_,int ys_,int zs_,int xe_,int ye_,int ze_, int radius_, irr::core::vector3d<double> left_, irr::core::vector3d<double> up_);
-		/// geometric primitive: sphere
-		void DrawSphere(int x_,int y_,int z_, int radius_);
-
-		/// Bresenham: longest axis = X
-		inline void Bresenham3dX(int xs_,int ys_,int zs_,int xe_,int ye_,int ze_, std::vector<SVoxelToDraw>& vector_);
-		/// Bresenham: longest axis = Y
-		inline void Bresenham3dY(int xs_,int ys_,int zs_,int xe_,int ye_,int ze_, std::vector<SVoxelToDraw>& vector_);
-		/// Bresenham: longest axis = Z
-		inline void Bresenham3dZ(int xs_,int ys_,int zs_,int xe_,int ye_,int ze_, std::vector<SVoxelToDraw>& vector_);
-		/// central call of the Bresenham algorithm
-		void Bresenham3d(int xs_,int ys_,int z_s,int xe_,int ye_,int ze_, std::vector<SVoxelToDraw>& vector_);
-
-		/// draws a 18-connected voxelblock around a central voxel
-		inline void DrawVoxelBlock(unsigned int x_,unsigned int y_,unsigned int z_);
-		/// creates a draws a voxel in 
-		inline void DrawVoxelToVector(int x_, int y_, int z_, std::vector<SVoxelToDraw>& vector_);
+		/// geometric primitive: capsule (cylinder with spheres at both ends, a sphere if start == end), only voxels with xBegin_ <= x < xEnd_ are drawn
+		void DrawCapsule(int xs_,int ys_,int zs_,int xe_,int ye_,int ze_, int radius_, int xBegin_, int xEnd_);
+		/// raises the stored distances to the surface of the capsule, only voxels with xBegin_ <= x < xEnd_ are drawn
+		void DrawCapsuleDistances(int xs_,int ys_,int zs_,int xe_,int ye_,int ze_, int radius_, int xBegin_, int xEnd_);
+		/// computes the span [zBegin_,zEnd_] of the row (x_,y_) inside the capsule, returns false if the row misses the capsule
+		bool GetCapsuleSpan(int x_, int y_, int xs_,int ys_,int zs_,int xe_,int ye_,int ze_, int radius_, int& zBegin_, int& zEnd_);
+		/// geometric primitive: sphere, only voxels with xBegin_ <= x < xEnd_ are drawn
+		void DrawSphere(int x_,int y_,int z_, int radius_, int xBegin_, int xEnd_);
+		/// adds a capsule to the list of primitives to rasterize
+		void AddPrimitive(int xs_,int ys_,int zs_,int xe_,int ye_,int ze_, int radius_);
+		/// rasterizes all primitives into the occupancy or into the distance field (in parallel, split up into slabs along X)
+		void RasterizePrimitives(bool distances_);
+		/// stores distances for the voxels at the cave surface and rasterizes the primitives into them
+		void ComputeDistanceField();
+		/// returns the span table of a sphere: half length of the Z-row (or -1) per |x|,|y| offset, index = |x|*(radius+1)+|y|
+		const std::vector<int>& GetSphereSpans(int radius_);
+
+		/// interprets the turtle graphic of the derivation:
+		/// without scaling_, the unscaled lines and their bounding box are computed (the lines are kept for the next Draw() with the same derivation and angles,
+		/// if keepSegments_ is set and they are not too many, else only the bounding box is computed), with scaling_, the lines are scaled into primitives directly
+		void InterpretTurtleGraphic(CLSystemExpansion& expansion_, double angleYaw_, double anglePitch_, double angleRoll_, const STurtleScaling* scaling_, bool keepSegments_);
+		/// pushes a turtle state on the stack (TurtleStates), depth_ is the number of pushed states
+		inline void PushTurtleState(const STurtleState& state_, unsigned int& depth_);
+		/// reads the next run of symbols from the derivation as one instruction for the turtle
+		inline STurtleOp ReadTurtleOp(CLSystemExpansion& expansion_) const;
+		/// test if a symbol has no meaning for the turtle
+		inline bool IsIgnoredTurtleSymbol(char symbol_) const;
+		/// gets cosinus and sinus of a rotation by count_ times the angle of the axis (0 = yaw, 1 = pitch, 2 = roll), tabulated for small counts
+		inline void GetTurtleRotation(unsigned int axis_, int count_, double& cos_, double& sin_) const;
+		/// scales an unscaled line into a primitive
+		void AddTurtleSegment(const STurtleSegment& segment_, const STurtleScaling& scaling_);
+
+		/// counts the 0<->1 junctions of the voxels of the brick beginning at (x_,y_,z_) (brick aligned) with their neighbors in negative X, Y and Z direction
+		unsigned int CountBrickJunctions(unsigned int x_, unsigned int y_, unsigned int z_) const;
 
 		/// ensures 3 voxel border
 		void EnsureIntegrity();
-
-		/// test if voxel is a cave border voxel (used by erosion)
-		inline bool IsBoundaryVoxel(unsigned int x_,unsigned int y_,unsigned int z_) const;
-		/// test if voxel is a cave border voxel (used by filtering)
-		inline bool IsBoundaryVoxelExtended(unsigned int x_,unsigned int y_,unsigned int z_) const;
-		/// fast test if voxel is a cave border voxel (used by filtering), test in positive direction
-		inline bool IsBoundaryVoxelBeginUpward(unsigned int x_,unsigned int y_,unsigned int z_) const;
-		/// fast test if voxel is a cave border voxel (used by filtering), test in negative direction
-		inline bool IsBoundaryVoxelBeginDownward(unsigned int x_,unsigned int y_,unsigned int z_) const;
+		/// sets all voxels of the region [xBegin_,xEnd_) x [yBegin_,yEnd_) x [zBegin_,zEnd_) to 0, only the dirty part is touched
+		void ClearRegion(unsigned int xBegin_, unsigned int xEnd_, unsigned int yBegin_, unsigned int yEnd_, unsigned int zBegin_, unsigned int zEnd_);
+
+		/// gets the X range [xBegin_,xEnd_) of an erosion slab (one brick thick, limited to the inner voxels)
+		inline void GetErosionSlab(int slab_, unsigned int& xBegin_, unsigned int& xEnd_) const;
+		/// appends the border voxels with xBegin_ <= x < xEnd_ in x/y/z order
+		void CollectBoundaryVoxels(unsigned int xBegin_, unsigned int xEnd_, std::vector<SVoxelToDraw>& boundary_) const;
+		/// moves the border voxels to erode into eroded_ (both keep their order), stream_ is the stream of the hash generator
+		void SelectErodedVoxels(std::vector<SVoxelToDraw>& boundary_, std::vector<SVoxelToDraw>& eroded_, double erosionLikelihood_, unsigned int stream_) const;
+		/// adds the 0-voxels of the slab, that have been exposed by the eroded voxels (of the slab and its neighbor slabs), to its sorted border voxels
+		void AddExposedVoxels(const std::vector<std::vector<SVoxelToDraw> >& eroded_, int slab_, std::vector<SVoxelToDraw>& boundary_) const;
+
+		/// remove hovering fragments as in older versions (flood fill of the outer hull)
+		unsigned int FilterOuterHull();
+		/// marks the outer hull (the 6-connected border voxels, extended test) reachable from the start voxel as HelperVoxel,
+		/// scanline flood fill: the border voxels are marked in runs along Z
+		void MarkOuterHull(const SVoxelToDraw& startVoxel_);
+
+		/// labels the 6-connected components of the voxels with the given occupancy:
+		/// the runs of every row (row x*DimY+y: runs_[rowRuns_[row]] to runs_[rowRuns_[row+1]-1]) and the component of every run (index of its first run)
+		void LabelComponents(unsigned char occupancy_, std::vector<SVoxelRun>& runs_, std::vector<unsigned int>& rowRuns_, std::vector<unsigned int>& components_) const;
+		/// appends the runs of the voxels with the given occupancy of the row (x_,y_), read a brick row at once
+		void CollectRowRuns(unsigned int x_, unsigned int y_, unsigned char occupancy_, std::vector<SVoxelRun>& runs_) const;
+		/// unites the components of the overlapping runs of 2 neighbor rows
+		static void UniteRows(const std::vector<SVoxelRun>& runs_, unsigned int row0Begin_, unsigned int row0End_,
+			unsigned int row1Begin_, unsigned int row1End_, std::vector<unsigned int>& parent_);
+		/// returns the root of a run (union-find, the root of a component is its run with the smallest index)
+		static inline unsigned int FindRootRun(std::vector<unsigned int>& parent_, unsigned int run_);
 
 	private:
 		/// voxel space
-		unsigned char Voxel[SVoxelSpace::DimX][SVoxelSpace::DimY][SVoxelSpace::DimZ];
+		CVoxelSpace VoxelSpace;
+		/// classification of the voxels (border voxels, junctions) a brick row at once
+		CVoxelClassifier Classifier;
+
+		/// span tables of the spheres drawn so far, indexed by radius
+		std::vector<std::vector<int> > SphereSpans;
+		/// primitives of the turtle graphic to rasterize
+		std::vector<SPrimitive> Primitives;
+
+		/// unscaled lines of the last interpreted turtle graphic
+		std::vector<STurtleSegment> TurtleSegments;
+		/// bounding box of the unscaled lines (including the origin)
+		irr::core::vector3d<double> TurtleMin, TurtleMax;
+		/// maximum number of radius reductions of the unscaled lines
+		unsigned int TurtleMaxReductions;
+		/// derivation and angles of the last interpreted turtle graphic
+		CLSystemExpansion TurtleExpansion;
+		double TurtleAngleYaw, TurtleAnglePitch, TurtleAngleRoll;
+		/// the unscaled lines are complete and belong to TurtleExpansion and the angles
+		bool TurtleSegmentsValid;
+		/// stack of turtle states ('['), kept between the interpretations
+		std::vector<STurtleState> TurtleStates;
+		/// maximum depth of the turtle stack of the last interpretation
+		unsigned int TurtlePeakDepth;
+		/// symbols without meaning for the turtle (skipped when reading the instructions)
+		bool TurtleIgnoredSymbols[CLSystem::SYMBOL_COUNT];
+		/// angles of the turtle rotations in radian measure (yaw, pitch, roll) of the current interpretation
+		double TurtleRotationAngles[3];
+		/// cosinus and sinus of the rotations by Count times the angles of the current interpretation, index = Count+MaxTabulatedRotation
+		double TurtleRotationCos[3][2*MaxTabulatedRotation+1];
+		double TurtleRotationSin[3][2*MaxTabulatedRotation+1];
 
 		/// random generator
 		const CRandomGenerator* RandomGenerator;
@@ -140,16 +340,57 @@ namespace DunGen
 
 		/// print status reports to console if true
 		bool PrintToConsole;
+
+		/// compute the distance field while drawing if true
+		bool DistanceFieldEnabled;
+		/// the voxel space holds the distance field of the last Draw()
+		bool DistanceFieldValid;
+		/// how hovering fragments are removed
+		EFilterMode::Enum FilterMode;
+		/// maximum number of runs waiting for the flood fill of the last Filter()
+		unsigned int FilterPeakFrontier;
+		/// sizes of the 0-voxel components of the last Filter()
+		std::vector<unsigned int> FragmentSizes;
+		/// number of erosions since the last Draw() (stream of the hash generator)
+		unsigned int ErosionCount;
+
+		/// number of 0<->1 junctions per brick of the last EstimateMeshComplexity() (empty: not counted yet)
+		std::vector<unsigned int> BrickJunctions;
+		/// sum of BrickJunctions
+		unsigned int JunctionCount;
+		/// bricks written to since the last EstimateMeshComplexity() (buffer)
+		std::vector<unsigned int> ChangedBricks;
+		/// bricks to be counted again by EstimateMeshComplexity() (buffer)
+		std::vector<unsigned int> StaleBricks;
+		/// new number of 0<->1 junctions of the stale bricks (buffer)
+		std::vector<unsigned int> StaleJunctions;
+		/// per brick: 1, if it is in StaleBricks (all 0 between calls)
+		std::vector<unsigned char> StaleBrickFlags;
 	};
 
 	void DunGen::CVoxelCave::SetVoxel(unsigned int x_, unsigned int y_, unsigned int z_, unsigned char value_)
 	{
-		Voxel[x_][y_][z_] = value_;
+		VoxelSpace.SetVoxel(x_,y_,z_,value_);
 	}
 
 	unsigned char DunGen::CVoxelCave::GetVoxel(unsigned int x_, unsigned int y_, unsigned int z_) const
 	{
-		return Voxel[x_][y_][z_];
+		return VoxelSpace.GetVoxel(x_,y_,z_);
+	}
+
+	unsigned int DunGen::CVoxelCave::GetBrickRowEnd(unsigned int z_, unsigned int zEnd_) const
+	{
+		const unsigned int rowEnd = (z_ | (CVoxelSpace::BrickSize-1)) + 1;
+		return rowEnd < zEnd_ ? rowEnd : zEnd_;
+	}
+
+	bool DunGen::CVoxelCave::IsRowWithoutJunction(unsigned int x_, unsigned int y_, unsigned int z_, unsigned int zEnd_) const
+	{
+		const CVoxelSpace::EBrickState::Enum state = VoxelSpace.GetBrickState(x_,y_,z_);
+		return CVoxelSpace::EBrickState::MIXED != state
+			&& state == VoxelSpace.GetBrickState(x_-1,y_,z_) && state == VoxelSpace.GetBrickState(x_+1,y_,z_)
+			&& state == VoxelSpace.GetBrickState(x_,y_-1,z_) && state == VoxelSpace.GetBrickState(x_,y_+1,z_)
+			&& state == VoxelSpace.GetBrickState(x_,y_,z_-1) && state == VoxelSpace.GetBrickState(x_,y_,zEnd_);
 	}
 
 	
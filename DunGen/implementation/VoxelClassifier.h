@@ -0,0 +1,226 @@
+// Copyright (C) 2011-2014 by Maximilian Hönig
+// This file is part of "DunGen - the Dungeongenerator".
+// For conditions of distribution and use, see licence.txt provided together with DunGen.
+
+#ifndef VOXELCLASSIFIER_H
+#define VOXELCLASSIFIER_H
+
+#include "VoxelSpace.h"
+
+// Namespace DunGen : DungeonGenerator
+namespace DunGen
+{
+	/// classification of the voxels of a voxel space a brick row at once
+	///
+	/// the BrickSize voxels of a row (x,y) inside a brick are read as one word of bits (bit i belongs to voxel z+i, z is brick aligned),
+	/// the neighborhood tests of a voxel become shifts, ANDs and ORs of the words of the row and its neighbor rows:
+	/// the neighbors along Z are the bits shifted by 1, the neighbors along X and Y are the bits of the neighbor rows
+	///
+	/// the values are classified as in CVoxelCave: a 0-voxel (stone) and a 1-voxel (free space) have no mark,
+	/// marked voxels (helper / docking voxels) are neither 0-voxels nor 1-voxels
+	///
+	/// only the voxels of the mask given to a test are classified, the neighbors of them have to be inside the voxel space
+	class CVoxelClassifier
+	{
+	public:
+		/// mask of all voxels of a brick row
+		static const unsigned int RowMask = (1u << CVoxelSpace::BrickSize) - 1;
+
+	public:
+		/// constructor
+		explicit CVoxelClassifier(const CVoxelSpace& voxelSpace_) : VoxelSpace(voxelSpace_) {}
+
+		/// returns the mask of the voxels [zBegin_,zEnd_) in the brick row beginning at z_ (the range has to overlap the brick row)
+		static inline unsigned int GetRowMask(unsigned int z_, unsigned int zBegin_, unsigned int zEnd_);
+
+		/// returns the number of set bits
+		static inline unsigned int CountBits(unsigned int bits_);
+
+		/// returns the index of the lowest set bit (bits_ must not be 0)
+		static inline unsigned int GetLowestBit(unsigned int bits_);
+
+		/// gets the bits of the 1-voxels and of the 0-voxels of the brick row beginning at z_
+		inline void GetValueRowBits(unsigned int x_, unsigned int y_, unsigned int z_, unsigned int& free_, unsigned int& stone_) const;
+
+		/// gets the bits of the voxels with the given occupancy (0 = stone, 1 = free space, marks are ignored) of the brick row beginning at z_
+		inline unsigned int GetOccupancyRowBits(unsigned int x_, unsigned int y_, unsigned int z_, unsigned char occupancy_) const;
+
+		/// gets the bits of the 1-voxels of the brick row beginning at z_ and of the voxels before and after it
+		/// (only read if before_ / after_ is set): bit 0 = voxel z_-1, bit i+1 = voxel z_+i, bit BrickSize+1 = voxel z_+BrickSize
+		inline unsigned int GetFreeRowBitsZ(unsigned int x_, unsigned int y_, unsigned int z_, bool before_, bool after_) const;
+
+		/// gets the bits of the voxels of mask_, that have a 6-connected 1-voxel
+		inline unsigned int GetFreeNeighborRowBits6(unsigned int x_, unsigned int y_, unsigned int z_, unsigned int mask_) const;
+
+		/// gets the bits of the voxels of mask_, that have an 18-connected 1-voxel
+		inline unsigned int GetFreeNeighborRowBits18(unsigned int x_, unsigned int y_, unsigned int z_, unsigned int mask_) const;
+
+		/// gets the bits of the border voxels of mask_: 0-voxels with a 6-connected 1-voxel (used by erosion)
+		inline unsigned int GetBoundaryRowBits(unsigned int x_, unsigned int y_, unsigned int z_, unsigned int mask_) const;
+
+		/// gets the bits of the border voxels of mask_: 0-voxels with an 18-connected 1-voxel (used by filtering)
+		inline unsigned int GetBoundaryRowBitsExtended(unsigned int x_, unsigned int y_, unsigned int z_, unsigned int mask_) const;
+
+		/// returns the number of 0<->1 junctions between the voxels of mask_ and their neighbors in negative X, Y and Z direction
+		inline unsigned int GetJunctionCount(unsigned int x_, unsigned int y_, unsigned int z_, unsigned int mask_) const;
+
+	private:
+		/// private copy constructor, because it shall not be used
+		CVoxelClassifier(const CVoxelClassifier& other_);
+		/// private assignment operator, because it shall not be used
+		CVoxelClassifier& operator=(const CVoxelClassifier& other_);
+
+	private:
+		/// the classified voxel space
+		const CVoxelSpace& VoxelSpace;
+	};
+
+	unsigned int DunGen::CVoxelClassifier::GetRowMask(unsigned int z_, unsigned int zBegin_, unsigned int zEnd_)
+	{
+		const unsigned int begin = zBegin_ > z_ ? zBegin_-z_ : 0;
+		const unsigned int end = zEnd_-z_ < CVoxelSpace::BrickSize ? zEnd_-z_ : CVoxelSpace::BrickSize;
+		return ((1u << end) - 1) & ~((1u << begin) - 1);
+	}
+
+	unsigned int DunGen::CVoxelClassifier::CountBits(unsigned int bits_)
+	{
+		// parallel sums of 2, 4 and 8 bits, the bytes are summed up by the multiplication
+		bits_ = bits_ - ((bits_>>1) & 0x55555555);
+		bits_ = (bits_ & 0x33333333) + ((bits_>>2) & 0x33333333);
+		bits_ = (bits_ + (bits_>>4)) & 0x0F0F0F0F;
+		return (bits_ * 0x01010101) >> 24;
+	}
+
+	unsigned int DunGen::CVoxelClassifier::GetLowestBit(unsigned int bits_)
+	{
+		// the lowest set bit alone has as many trailing zeros
+		return CountBits((bits_ & (0u-bits_)) - 1);
+	}
+
+	void DunGen::CVoxelClassifier::GetValueRowBits(unsigned int x_, unsigned int y_, unsigned int z_, unsigned int& free_, unsigned int& stone_) const
+	{
+		unsigned int occupancy, marks;
+		VoxelSpace.GetRowBits(x_,y_,z_,occupancy,marks);
+		free_ = occupancy & ~marks;
+		stone_ = ~(occupancy | marks) & RowMask;
+	}
+
+	unsigned int DunGen::CVoxelClassifier::GetOccupancyRowBits(unsigned int x_, unsigned int y_, unsigned int z_, unsigned char occupancy_) const
+	{
+		unsigned int occupancy, marks;
+		VoxelSpace.GetRowBits(x_,y_,z_,occupancy,marks);
+		return occupancy_ ? occupancy : ~occupancy & RowMask;
+	}
+
+	unsigned int DunGen::CVoxelClassifier::GetFreeRowBitsZ(unsigned int x_, unsigned int y_, unsigned int z_, bool before_, bool after_) const
+	{
+		unsigned int occupancy, marks;
+		VoxelSpace.GetRowBits(x_,y_,z_,occupancy,marks);
+		unsigned int bits = (occupancy & ~marks) << 1;
+
+		// the voxels before and after the row
+		if (before_ && z_ > 0 && 1 == VoxelSpace.GetVoxel(x_,y_,z_-1))
+			bits |= 1;
+		if (after_ && z_+CVoxelSpace::BrickSize < VoxelSpace.GetDimZ() && 1 == VoxelSpace.GetVoxel(x_,y_,z_+CVoxelSpace::BrickSize))
+			bits |= 1u << (CVoxelSpace::BrickSize+1);
+		return bits;
+	}
+
+	unsigned int DunGen::CVoxelClassifier::GetFreeNeighborRowBits6(unsigned int x_, unsigned int y_, unsigned int z_, unsigned int mask_) const
+	{
+		// the rows with 1 offset in X or Y
+		static const int edgeRows[4][2] = {{-1,0},{1,0},{0,-1},{0,1}};
+
+		// 1-voxels along Z (bits of GetFreeRowBitsZ() shifted by 0 and 2 -> Z-1 and Z+1),
+		// the voxels before and after the row are only needed for voxels at its ends
+		const unsigned int row = GetFreeRowBitsZ(x_,y_,z_,0 != (mask_ & 1),0 != (mask_ >> (CVoxelSpace::BrickSize-1)));
+		unsigned int free = row | (row>>2);
+
+		// 1-voxels with the same Z in the neighbor rows
+		unsigned int edgeFree, edgeStone;
+		for (unsigned int n=0; n<4; ++n)
+		{
+			GetValueRowBits(x_+edgeRows[n][0],y_+edgeRows[n][1],z_,edgeFree,edgeStone);
+			free |= edgeFree;
+		}
+
+		return free & mask_;
+	}
+
+	unsigned int DunGen::CVoxelClassifier::GetFreeNeighborRowBits18(unsigned int x_, unsigned int y_, unsigned int z_, unsigned int mask_) const
+	{
+		// the rows with 1 offset in X or Y, their neighbors along Z are 18-connected
+		static const int edgeRows[4][2] = {{-1,0},{1,0},{0,-1},{0,1}};
+		// the rows with 1 offset in X and Y, only the voxels with the same Z are 18-connected
+		static const int cornerRows[4][2] = {{-1,-1},{-1,1},{1,-1},{1,1}};
+
+		// 1-voxels next to the voxels of the row (bits of GetFreeRowBitsZ() shifted by 0, 1, 2 -> Z-1, Z, Z+1),
+		// the voxels before and after the row are only needed for voxels at its ends
+		const bool before = 0 != (mask_ & 1);
+		const bool after = 0 != (mask_ >> (CVoxelSpace::BrickSize-1));
+		const unsigned int row = GetFreeRowBitsZ(x_,y_,z_,before,after);
+		unsigned int free = row | (row>>2);
+		for (unsigned int n=0; n<4; ++n)
+		{
+			const unsigned int edgeRow = GetFreeRowBitsZ(x_+edgeRows[n][0],y_+edgeRows[n][1],z_,before,after);
+			free |= edgeRow | (edgeRow>>1) | (edgeRow>>2);
+		}
+		unsigned int cornerFree, cornerStone;
+		for (unsigned int n=0; n<4; ++n)
+		{
+			GetValueRowBits(x_+cornerRows[n][0],y_+cornerRows[n][1],z_,cornerFree,cornerStone);
+			free |= cornerFree;
+		}
+
+		return free & mask_;
+	}
+
+	unsigned int DunGen::CVoxelClassifier::GetBoundaryRowBits(unsigned int x_, unsigned int y_, unsigned int z_, unsigned int mask_) const
+	{
+		// a border voxel has to be a 0-voxel, the neighbors are only read for the 0-voxels
+		unsigned int free, stone;
+		GetValueRowBits(x_,y_,z_,free,stone);
+		stone &= mask_;
+		if (0 == stone)
+			return 0;
+		return GetFreeNeighborRowBits6(x_,y_,z_,stone);
+	}
+
+	unsigned int DunGen::CVoxelClassifier::GetBoundaryRowBitsExtended(unsigned int x_, unsigned int y_, unsigned int z_, unsigned int mask_) const
+	{
+		// a border voxel has to be a 0-voxel (marked voxels have been visited already by filtering: they are skipped quickly)
+		unsigned int free, stone;
+		GetValueRowBits(x_,y_,z_,free,stone);
+		stone &= mask_;
+		if (0 == stone)
+			return 0;
+		return GetFreeNeighborRowBits18(x_,y_,z_,stone);
+	}
+
+	unsigned int DunGen::CVoxelClassifier::GetJunctionCount(unsigned int x_, unsigned int y_, unsigned int z_, unsigned int mask_) const
+	{
+		unsigned int free, stone, freeX, stoneX, freeY, stoneY;
+		GetValueRowBits(x_,y_,z_,free,stone);
+		GetValueRowBits(x_-1,y_,z_,freeX,stoneX);
+		GetValueRowBits(x_,y_-1,z_,freeY,stoneY);
+
+		// the row shifted by 1 voxel along Z, the voxel before the row is only needed for the first voxel
+		unsigned int freeZ = free<<1;
+		unsigned int stoneZ = stone<<1;
+		if ((mask_ & 1) && z_ > 0)
+		{
+			const unsigned char value = VoxelSpace.GetVoxel(x_,y_,z_-1);
+			if (1 == value)
+				freeZ |= 1;
+			else if (0 == value)
+				stoneZ |= 1;
+		}
+
+		return CountBits(((free & stoneX) | (stone & freeX)) & mask_)
+			+ CountBits(((free & stoneY) | (stone & freeY)) & mask_)
+			+ CountBits(((free & stoneZ) | (stone & freeZ)) & mask_);
+	}
+
+} // END NAMESPACE DunGen
+
+#endif
@@ -0,0 +1,239 @@
+// Copyright (C) 2011-2014 by Maximilian Hönig
+// This file is part of "DunGen - the Dungeongenerator".
+// For conditions of distribution and use, see licence.txt provided together with DunGen.
+
+#include "VoxelSpace.h"
+#include <algorithm>
+#include <string.h>
+
+// ======================================================
+// constructor / destructor
+// ======================================================
+
+DunGen::CVoxelSpace::CVoxelSpace(unsigned int dimX_, unsigned int dimY_, unsigned int dimZ_)
+	: DimX(0), DimY(0), DimZ(0)
+	, BricksX(0), BricksY(0), BricksZ(0)
+	, ClearedBytes(0)
+{
+	SetDimensions(dimX_, dimY_, dimZ_);
+}
+
+DunGen::CVoxelSpace::~CVoxelSpace()
+{
+	ReleaseBricks();
+}
+
+// ======================================================
+// storage management
+// ======================================================
+
+void DunGen::CVoxelSpace::SetDimensions(unsigned int dimX_, unsigned int dimY_, unsigned int dimZ_)
+{
+	// nothing to do, if the dimensions are unchanged
+	if (!Bricks.empty() && dimX_ == DimX && dimY_ == DimY && dimZ_ == DimZ)
+		return;
+
+	// release old storage
+	ReleaseBricks();
+
+	// compute brick layout
+	DimX = dimX_;
+	DimY = dimY_;
+	DimZ = dimZ_;
+	BricksX = (DimX + BrickSize - 1) >> BrickShift;
+	BricksY = (DimY + BrickSize - 1) >> BrickShift;
+	BricksZ = (DimZ + BrickSize - 1) >> BrickShift;
+
+	// all bricks are uniform 0
+	SBrick emptyBrick;
+	emptyBrick.Occupancy = NULL;
+	emptyBrick.Marks = NULL;
+	emptyBrick.Distance = NULL;
+	emptyBrick.UniformValue = 0;
+	emptyBrick.Changed = true;
+	Bricks.assign(BricksX*BricksY*BricksZ, emptyBrick);
+	ResetDirtyRegion();
+
+	// all bricks are new
+	ChangedBricks.resize(Bricks.size());
+	for (unsigned int i=0; i<ChangedBricks.size(); ++i)
+		ChangedBricks[i] = i;
+}
+
+void DunGen::CVoxelSpace::Clear()
+{
+	ClearedBytes = 0;
+
+	// only the bricks of the dirty region may be non-empty
+	for (unsigned int x=DirtyBrickMin.X; x<DirtyBrickMax.X; ++x)
+		for (unsigned int y=DirtyBrickMin.Y; y<DirtyBrickMax.Y; ++y)
+			for (unsigned int z=DirtyBrickMin.Z; z<DirtyBrickMax.Z; ++z)
+			{
+				SBrick& brick = Bricks[(x*BricksY + y)*BricksZ + z];
+				if (brick.Occupancy)
+					ClearedBytes += sizeof(unsigned int)*WordsPerBrick;
+				if (brick.Marks)
+					ClearedBytes += sizeof(unsigned int)*WordsPerBrick;
+				if (brick.Distance)
+					ClearedBytes += VoxelsPerBrick;
+				ClearedBytes += sizeof(SBrick);
+
+				delete[] brick.Occupancy;
+				delete[] brick.Marks;
+				delete[] brick.Distance;
+				brick.Occupancy = NULL;
+				brick.Marks = NULL;
+				brick.Distance = NULL;
+				brick.UniformValue = 0;
+				MarkChanged(brick);
+			}
+
+	ResetDirtyRegion();
+}
+
+void DunGen::CVoxelSpace::GetDirtyRegion(irr::core::vector3d<unsigned int>& min_, irr::core::vector3d<unsigned int>& max_) const
+{
+	min_.set(DirtyBrickMin.X*BrickSize, DirtyBrickMin.Y*BrickSize, DirtyBrickMin.Z*BrickSize);
+	max_.set(std::min(DirtyBrickMax.X*BrickSize, DimX),
+		std::min(DirtyBrickMax.Y*BrickSize, DimY),
+		std::min(DirtyBrickMax.Z*BrickSize, DimZ));
+}
+
+void DunGen::CVoxelSpace::MarkDirty(unsigned int x_, unsigned int y_, unsigned int z_)
+{
+	const unsigned int x = x_>>BrickShift;
+	const unsigned int y = y_>>BrickShift;
+	const unsigned int z = z_>>BrickShift;
+
+	// bricks may be split up by several threads at once (rasterization in slabs)
+	#pragma omp critical (VoxelSpaceDirtyRegion)
+	{
+		if (x < DirtyBrickMin.X) DirtyBrickMin.X = x;
+		if (y < DirtyBrickMin.Y) DirtyBrickMin.Y = y;
+		if (z < DirtyBrickMin.Z) DirtyBrickMin.Z = z;
+		if (x >= DirtyBrickMax.X) DirtyBrickMax.X = x+1;
+		if (y >= DirtyBrickMax.Y) DirtyBrickMax.Y = y+1;
+		if (z >= DirtyBrickMax.Z) DirtyBrickMax.Z = z+1;
+	}
+}
+
+void DunGen::CVoxelSpace::ResetDirtyRegion()
+{
+	DirtyBrickMin.set(BricksX, BricksY, BricksZ);
+	DirtyBrickMax.set(0, 0, 0);
+}
+
+void DunGen::CVoxelSpace::AddChangedBrick(SBrick& brick_)
+{
+	// bricks may be written by several threads at once (rasterization in slabs), but every brick only by one of them
+	brick_.Changed = true;
+	#pragma omp critical (VoxelSpaceChangedBricks)
+	{
+		ChangedBricks.push_back(static_cast<unsigned int>(&brick_ - &Bricks[0]));
+	}
+}
+
+void DunGen::CVoxelSpace::TakeChangedBricks(std::vector<unsigned int>& bricks_)
+{
+	bricks_.clear();
+	bricks_.swap(ChangedBricks);
+	for (unsigned int i=0; i<bricks_.size(); ++i)
+		Bricks[bricks_[i]].Changed = false;
+}
+
+void DunGen::CVoxelSpace::ReleaseBricks()
+{
+	for (unsigned int i=0; i<Bricks.size(); ++i)
+	{
+		delete[] Bricks[i].Occupancy;
+		delete[] Bricks[i].Marks;
+		delete[] Bricks[i].Distance;
+		Bricks[i].Occupancy = NULL;
+		Bricks[i].Marks = NULL;
+		Bricks[i].Distance = NULL;
+		Bricks[i].UniformValue = 0;
+	}
+}
+
+void DunGen::CVoxelSpace::SplitBrick(SBrick& brick_, unsigned int x_, unsigned int y_, unsigned int z_)
+{
+	brick_.Occupancy = new unsigned int[WordsPerBrick];
+	memset(brick_.Occupancy,brick_.UniformValue ? 0xff : 0,sizeof(unsigned int)*WordsPerBrick);
+	MarkDirty(x_,y_,z_);
+}
+
+void DunGen::CVoxelSpace::AllocateMarks(SBrick& brick_, unsigned int x_, unsigned int y_, unsigned int z_)
+{
+	brick_.Marks = new unsigned int[WordsPerBrick];
+	memset(brick_.Marks,0,sizeof(unsigned int)*WordsPerBrick);
+	MarkDirty(x_,y_,z_);
+}
+
+void DunGen::CVoxelSpace::AllocateDistance(SBrick& brick_, unsigned int x_, unsigned int y_, unsigned int z_)
+{
+	brick_.Distance = new signed char[VoxelsPerBrick];
+	memset(brick_.Distance,NoDistance,VoxelsPerBrick);
+	MarkDirty(x_,y_,z_);
+}
+
+void DunGen::CVoxelSpace::Compact()
+{
+	for (unsigned int i=0; i<Bricks.size(); ++i)
+	{
+		SBrick& brick = Bricks[i];
+
+		// merge uniform occupancy
+		if (brick.Occupancy)
+		{
+			const unsigned int first = brick.Occupancy[0];
+			bool uniform = (0 == first || ~0u == first);
+			for (unsigned int j=1; j<WordsPerBrick && uniform; ++j)
+				uniform = (brick.Occupancy[j] == first);
+
+			if (uniform)
+			{
+				delete[] brick.Occupancy;
+				brick.Occupancy = NULL;
+				brick.UniformValue = first ? 1 : 0;
+			}
+		}
+
+		// release empty marks
+		if (brick.Marks)
+		{
+			bool empty = true;
+			for (unsigned int j=0; j<WordsPerBrick && empty; ++j)
+				empty = (0 == brick.Marks[j]);
+
+			if (empty)
+			{
+				delete[] brick.Marks;
+				brick.Marks = NULL;
+			}
+		}
+	}
+}
+
+unsigned int DunGen::CVoxelSpace::GetAllocatedBytes() const
+{
+	unsigned int bytes = sizeof(SBrick)*Bricks.size();		// brick table
+	for (unsigned int i=0; i<Bricks.size(); ++i)
+	{
+		if (Bricks[i].Occupancy)
+			bytes += sizeof(unsigned int)*WordsPerBrick;
+		if (Bricks[i].Marks)
+			bytes += sizeof(unsigned int)*WordsPerBrick;
+		if (Bricks[i].Distance)
+			bytes += VoxelsPerBrick;
+	}
+	return bytes;
+}
+
+unsigned int DunGen::CVoxelSpace::GetMixedBrickCount() const
+{
+	unsigned int count = 0;
+	for (unsigned int i=0; i<Bricks.size(); ++i)
+		if (Bricks[i].Occupancy)
+			++count;
+	return count;
+}
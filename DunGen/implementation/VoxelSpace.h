@@ -0,0 +1,377 @@
+// Copyright (C) 2011-2014 by Maximilian Hönig
+// This file is part of "DunGen - the Dungeongenerator".
+// For conditions of distribution and use, see licence.txt provided together with DunGen.
+
+#ifndef VOXELSPACE_H
+#define VOXELSPACE_H
+
+#include "interface/VoxelCaveCommon.h"
+#include <irrlicht.h>
+#include <vector>
+
+// Namespace DunGen : DungeonGenerator
+namespace DunGen
+{
+	/// bit-packed, brick based voxel space
+	///
+	/// the voxel space is split up into bricks of BrickSize^3 voxels,
+	/// a brick with uniform occupancy (all 0 or all 1) needs no storage,
+	/// a mixed brick stores 1 bit per voxel for the occupancy (0 = stone, 1 = free space),
+	/// the transient marks (helper / docking voxels) are stored in an extra bit array per brick, only if needed,
+	/// a voxel value is composed as: occupancy | (mark<<1) -> values 0..3
+	///
+	/// optionally, a quantized signed distance to the cave surface can be stored per voxel (1 byte),
+	/// only for the voxels next to the surface: positive in free space, negative in stone, saturated at +-DistanceMax,
+	/// voxels without stored distance are saturated according to their occupancy
+	///
+	/// the bounding box of all bricks, that have been written to, is tracked (dirty region),
+	/// so clearing only has to touch this region
+	///
+	/// the bricks written to are collected (changed bricks), so derived data can be recomputed only for the bricks, that have changed since
+	///
+	/// the voxels inside a brick are stored linear (z fastest) by default,
+	/// define DUNGEN_VOXEL_LAYOUT_MORTON to store the rows in Z-order (Morton order of x and y) instead:
+	/// the rows stay contiguous (one half word each, as needed by the row functions), but the rows of every aligned 2x2 tile share 8 bytes,
+	/// which keeps the neighbor rows in X direction close (linear layout: BrickSize*BrickSize*2 bytes apart)
+	class CVoxelSpace
+	{
+	public:
+		/// edge length of a brick (power of 2)
+		static const unsigned int BrickSize = 16;
+
+		/// number of distance steps per voxel
+		static const int DistanceScale = 64;
+		/// distance band around the surface in voxels, farther distances are saturated
+		/// (the surface only runs between voxels, that are at most 1 voxel away from it)
+		static const int DistanceBand = 1;
+		/// saturated distance value
+		static const int DistanceMax = DistanceScale*DistanceBand;
+
+		/// occupancy state of a brick
+		struct EBrickState
+		{
+			enum Enum
+			{
+				UNIFORM_0 = 0,	///< all voxels have occupancy 0
+				UNIFORM_1,		///< all voxels have occupancy 1
+				MIXED			///< the brick has voxels with occupancy 0 and 1
+			};
+		};
+
+	private:
+		/// brick edge length as shift
+		static const unsigned int BrickShift = 4;
+		/// mask for the local coordinates in a brick
+		static const unsigned int BrickMask = BrickSize-1;
+		/// number of bits per storage word
+		static const unsigned int BitsPerWord = 32;
+		/// number of voxels per brick
+		static const unsigned int VoxelsPerBrick = BrickSize*BrickSize*BrickSize;
+		/// number of storage words per brick
+		static const unsigned int WordsPerBrick = VoxelsPerBrick / BitsPerWord;
+		/// distance entry of a voxel without stored distance
+		static const int NoDistance = -128;
+
+		/// a brick of the voxel space
+		struct SBrick
+		{
+			unsigned int* Occupancy;		///< occupancy bits, NULL if uniform
+			unsigned int* Marks;			///< mark bits, NULL if there are no marks
+			signed char* Distance;			///< quantized signed distances, NULL if not stored
+			unsigned char UniformValue;		///< occupancy of all voxels, if Occupancy is NULL
+			bool Changed;					///< the brick has been written to since the last TakeChangedBricks()
+		};
+
+	public:
+		/// constructor
+		CVoxelSpace(unsigned int dimX_, unsigned int dimY_, unsigned int dimZ_);
+		/// destructor
+		~CVoxelSpace();
+
+		/// sets the dimensions of the voxel space, content is cleared if they change
+		void SetDimensions(unsigned int dimX_, unsigned int dimY_, unsigned int dimZ_);
+
+		/// get X dimension
+		unsigned int GetDimX() const {return DimX;}
+		/// get Y dimension
+		unsigned int GetDimY() const {return DimY;}
+		/// get Z dimension
+		unsigned int GetDimZ() const {return DimZ;}
+
+		/// sets all voxels to 0 and releases all brick storage (only the dirty region is touched)
+		void Clear();
+
+		/// returns the number of bytes touched by the last Clear()
+		unsigned int GetClearedBytes() const {return ClearedBytes;}
+
+		/// gets the dirty region in voxels (min inclusive, max exclusive), all voxels outside of it are 0
+		void GetDirtyRegion(irr::core::vector3d<unsigned int>& min_, irr::core::vector3d<unsigned int>& max_) const;
+
+		/// releases the storage of all bricks that became uniform and of all mark arrays without marks
+		void Compact();
+
+		/// returns the number of bytes currently allocated for voxel storage
+		unsigned int GetAllocatedBytes() const;
+
+		/// returns the number of bricks with allocated occupancy storage
+		unsigned int GetMixedBrickCount() const;
+
+		/// sets a voxel to a specific value (0..3)
+		inline void SetVoxel(unsigned int x_, unsigned int y_, unsigned int z_, unsigned char value_);
+
+		/// gets the value of a voxel (0..3)
+		inline unsigned char GetVoxel(unsigned int x_, unsigned int y_, unsigned int z_) const;
+
+		/// sets the voxels [zBegin_,zEnd_) of the row (x_,y_) to 1, word-wise per brick
+		inline void FillRow(unsigned int x_, unsigned int y_, unsigned int zBegin_, unsigned int zEnd_);
+
+		/// gets the occupancy and mark bits of the BrickSize voxels of the row (x_,y_) beginning at z_ (brick aligned), bit i belongs to voxel z_+i
+		inline void GetRowBits(unsigned int x_, unsigned int y_, unsigned int z_, unsigned int& occupancy_, unsigned int& marks_) const;
+
+		/// stores a distance for the voxel from now on, initialized to -DistanceMax
+		inline void EnableDistance(unsigned int x_, unsigned int y_, unsigned int z_);
+
+		/// tests if a distance is stored for the voxel
+		inline bool HasDistance(unsigned int x_, unsigned int y_, unsigned int z_) const;
+
+		/// raises the stored distance of a voxel to value_ (union of primitives: the maximum is kept), the distance has to be enabled
+		inline void RaiseDistance(unsigned int x_, unsigned int y_, unsigned int z_, int value_);
+
+		/// gets the signed distance of a voxel (saturated by occupancy, if not stored)
+		inline int GetDistance(unsigned int x_, unsigned int y_, unsigned int z_) const;
+
+		/// gets the occupancy state of the brick containing the voxel
+		inline EBrickState::Enum GetBrickState(unsigned int x_, unsigned int y_, unsigned int z_) const;
+
+		/// gets the bricks written to since the last call and resets them to unchanged, a brick (x,y,z) is given as (x*BricksY + y)*BricksZ + z
+		/// (all bricks are changed after SetDimensions())
+		void TakeChangedBricks(std::vector<unsigned int>& bricks_);
+
+		/// get number of bricks in X dimension
+		unsigned int GetBricksX() const {return BricksX;}
+		/// get number of bricks in Y dimension
+		unsigned int GetBricksY() const {return BricksY;}
+		/// get number of bricks in Z dimension
+		unsigned int GetBricksZ() const {return BricksZ;}
+
+		/// tests if the brick containing the voxel has any marks (may also return true, if all marks have been removed since the last Compact())
+		inline bool HasMarks(unsigned int x_, unsigned int y_, unsigned int z_) const;
+
+	private:
+		/// private copy constructor, because it shall not be used
+		CVoxelSpace(const CVoxelSpace& other_);
+		/// private assignment operator, because it shall not be used
+		CVoxelSpace& operator=(const CVoxelSpace& other_);
+
+		/// releases the storage of all bricks
+		void ReleaseBricks();
+
+		/// allocates the occupancy storage of a uniform brick, (x_,y_,z_) is a voxel inside the brick
+		void SplitBrick(SBrick& brick_, unsigned int x_, unsigned int y_, unsigned int z_);
+		/// allocates the (empty) mark storage of a brick, (x_,y_,z_) is a voxel inside the brick
+		void AllocateMarks(SBrick& brick_, unsigned int x_, unsigned int y_, unsigned int z_);
+		/// allocates the distance storage of a brick (no distance stored yet), (x_,y_,z_) is a voxel inside the brick
+		void AllocateDistance(SBrick& brick_, unsigned int x_, unsigned int y_, unsigned int z_);
+		/// adds the brick containing the voxel to the dirty region
+		void MarkDirty(unsigned int x_, unsigned int y_, unsigned int z_);
+		/// resets the dirty region to empty
+		void ResetDirtyRegion();
+		/// adds the brick to the changed bricks, if it is not changed yet
+		inline void MarkChanged(SBrick& brick_);
+		/// adds the brick to the changed bricks
+		void AddChangedBrick(SBrick& brick_);
+
+		/// returns the brick containing the voxel
+		inline SBrick& GetBrick(unsigned int x_, unsigned int y_, unsigned int z_);
+		/// returns the brick containing the voxel
+		inline const SBrick& GetBrick(unsigned int x_, unsigned int y_, unsigned int z_) const;
+		/// returns the index of the voxel inside its brick
+		static inline unsigned int GetIndexInBrick(unsigned int x_, unsigned int y_, unsigned int z_);
+		/// spreads the bits of a local brick coordinate to every second bit (for Morton order)
+		static inline unsigned int SpreadBits(unsigned int value_);
+
+	private:
+		/// dimensions
+		unsigned int DimX, DimY, DimZ;
+		/// number of bricks per dimension
+		unsigned int BricksX, BricksY, BricksZ;
+
+		/// the bricks, z is the fastest running brick coordinate
+		std::vector<SBrick> Bricks;
+
+		/// dirty region in bricks (min inclusive, max exclusive)
+		irr::core::vector3d<unsigned int> DirtyBrickMin, DirtyBrickMax;
+		/// number of bytes touched by the last Clear()
+		unsigned int ClearedBytes;
+
+		/// indices of the bricks written to since the last TakeChangedBricks()
+		std::vector<unsigned int> ChangedBricks;
+	};
+
+	DunGen::CVoxelSpace::SBrick& DunGen::CVoxelSpace::GetBrick(unsigned int x_, unsigned int y_, unsigned int z_)
+	{
+		return Bricks[((x_>>BrickShift)*BricksY + (y_>>BrickShift))*BricksZ + (z_>>BrickShift)];
+	}
+
+	const DunGen::CVoxelSpace::SBrick& DunGen::CVoxelSpace::GetBrick(unsigned int x_, unsigned int y_, unsigned int z_) const
+	{
+		return Bricks[((x_>>BrickShift)*BricksY + (y_>>BrickShift))*BricksZ + (z_>>BrickShift)];
+	}
+
+	unsigned int DunGen::CVoxelSpace::GetIndexInBrick(unsigned int x_, unsigned int y_, unsigned int z_)
+	{
+#ifdef DUNGEN_VOXEL_LAYOUT_MORTON
+		// Z-order of the rows inside the brick: the bits of the local x and y coordinates are interleaved (x y x y ...), z is the fastest running coordinate
+		return (((SpreadBits(x_&BrickMask)<<1) | SpreadBits(y_&BrickMask))<<BrickShift) | (z_&BrickMask);
+#else
+		// linear layout inside the brick, z is the fastest running coordinate
+		return ((x_&BrickMask)<<(2*BrickShift)) | ((y_&BrickMask)<<BrickShift) | (z_&BrickMask);
+#endif
+	}
+
+	unsigned int DunGen::CVoxelSpace::SpreadBits(unsigned int value_)
+	{
+		// 4 bits: b3 b2 b1 b0 -> b3 0 b2 0 b1 0 b0
+		value_ = (value_ | (value_<<2)) & 0x33;
+		value_ = (value_ | (value_<<1)) & 0x55;
+		return value_;
+	}
+
+	void DunGen::CVoxelSpace::SetVoxel(unsigned int x_, unsigned int y_, unsigned int z_, unsigned char value_)
+	{
+		SBrick& brick = GetBrick(x_,y_,z_);
+		const unsigned int index = GetIndexInBrick(x_,y_,z_);
+		const unsigned int bit = 1u << (index & (BitsPerWord-1));
+		const unsigned char occupancy = value_ & 1;
+		MarkChanged(brick);
+
+		// occupancy, a uniform brick is only split up if the value differs
+		if (!brick.Occupancy && occupancy != brick.UniformValue)
+			SplitBrick(brick,x_,y_,z_);
+		if (brick.Occupancy)
+		{
+			if (occupancy)
+				brick.Occupancy[index/BitsPerWord] |= bit;
+			else
+				brick.Occupancy[index/BitsPerWord] &= ~bit;
+		}
+
+		// mark
+		if (value_ & 2)
+		{
+			if (!brick.Marks)
+				AllocateMarks(brick,x_,y_,z_);
+			brick.Marks[index/BitsPerWord] |= bit;
+		}
+		else if (brick.Marks)
+			brick.Marks[index/BitsPerWord] &= ~bit;
+	}
+
+	unsigned char DunGen::CVoxelSpace::GetVoxel(unsigned int x_, unsigned int y_, unsigned int z_) const
+	{
+		const SBrick& brick = GetBrick(x_,y_,z_);
+
+		// fast path: uniform brick without marks
+		if (!brick.Occupancy && !brick.Marks)
+			return brick.UniformValue;
+
+		const unsigned int index = GetIndexInBrick(x_,y_,z_);
+		const unsigned int shift = index & (BitsPerWord-1);
+
+		unsigned char value = brick.Occupancy
+			? static_cast<unsigned char>((brick.Occupancy[index/BitsPerWord] >> shift) & 1)
+			: brick.UniformValue;
+		if (brick.Marks)
+			value |= static_cast<unsigned char>(((brick.Marks[index/BitsPerWord] >> shift) & 1) << 1);
+		return value;
+	}
+
+	void DunGen::CVoxelSpace::FillRow(unsigned int x_, unsigned int y_, unsigned int zBegin_, unsigned int zEnd_)
+	{
+		// the part of a row inside a brick lies in one word (in both layouts)
+		while (zBegin_ < zEnd_)
+		{
+			const unsigned int rowEnd = (zBegin_ | BrickMask) + 1;
+			const unsigned int chunkEnd = rowEnd < zEnd_ ? rowEnd : zEnd_;
+			const unsigned int index = GetIndexInBrick(x_,y_,zBegin_);
+			const unsigned int mask = ((1u << (chunkEnd-zBegin_)) - 1) << (index & (BitsPerWord-1));
+
+			SBrick& brick = GetBrick(x_,y_,zBegin_);
+			MarkChanged(brick);
+			if (!brick.Occupancy && 1 != brick.UniformValue)
+				SplitBrick(brick,x_,y_,zBegin_);
+			if (brick.Occupancy)
+				brick.Occupancy[index/BitsPerWord] |= mask;
+			if (brick.Marks)
+				brick.Marks[index/BitsPerWord] &= ~mask;
+
+			zBegin_ = chunkEnd;
+		}
+	}
+
+	void DunGen::CVoxelSpace::GetRowBits(unsigned int x_, unsigned int y_, unsigned int z_, unsigned int& occupancy_, unsigned int& marks_) const
+	{
+		// the part of a row inside a brick lies in one word (in both layouts)
+		const unsigned int rowMask = (1u << BrickSize) - 1;
+		const SBrick& brick = GetBrick(x_,y_,z_);
+		const unsigned int index = GetIndexInBrick(x_,y_,z_);
+		const unsigned int shift = index & (BitsPerWord-1);
+		occupancy_ = brick.Occupancy ? (brick.Occupancy[index/BitsPerWord] >> shift) & rowMask : (brick.UniformValue ? rowMask : 0);
+		marks_ = brick.Marks ? (brick.Marks[index/BitsPerWord] >> shift) & rowMask : 0;
+	}
+
+	void DunGen::CVoxelSpace::EnableDistance(unsigned int x_, unsigned int y_, unsigned int z_)
+	{
+		SBrick& brick = GetBrick(x_,y_,z_);
+		if (!brick.Distance)
+			AllocateDistance(brick,x_,y_,z_);
+		brick.Distance[GetIndexInBrick(x_,y_,z_)] = static_cast<signed char>(-DistanceMax);
+	}
+
+	bool DunGen::CVoxelSpace::HasDistance(unsigned int x_, unsigned int y_, unsigned int z_) const
+	{
+		const SBrick& brick = GetBrick(x_,y_,z_);
+		return brick.Distance && NoDistance != brick.Distance[GetIndexInBrick(x_,y_,z_)];
+	}
+
+	void DunGen::CVoxelSpace::RaiseDistance(unsigned int x_, unsigned int y_, unsigned int z_, int value_)
+	{
+		signed char& distance = GetBrick(x_,y_,z_).Distance[GetIndexInBrick(x_,y_,z_)];
+		if (value_ > distance)
+			distance = static_cast<signed char>(value_);
+	}
+
+	int DunGen::CVoxelSpace::GetDistance(unsigned int x_, unsigned int y_, unsigned int z_) const
+	{
+		const bool occupied = 0 != (GetVoxel(x_,y_,z_) & 1);
+		if (HasDistance(x_,y_,z_))
+		{
+			// free space without a positive distance lies deeper inside a primitive than the distance band
+			const int distance = GetBrick(x_,y_,z_).Distance[GetIndexInBrick(x_,y_,z_)];
+			return (occupied && distance < 0) ? DistanceMax : distance;
+		}
+		return occupied ? DistanceMax : -DistanceMax;
+	}
+
+	DunGen::CVoxelSpace::EBrickState::Enum DunGen::CVoxelSpace::GetBrickState(unsigned int x_, unsigned int y_, unsigned int z_) const
+	{
+		const SBrick& brick = GetBrick(x_,y_,z_);
+		if (brick.Occupancy)
+			return EBrickState::MIXED;
+		return brick.UniformValue ? EBrickState::UNIFORM_1 : EBrickState::UNIFORM_0;
+	}
+
+	void DunGen::CVoxelSpace::MarkChanged(SBrick& brick_)
+	{
+		if (!brick_.Changed)
+			AddChangedBrick(brick_);
+	}
+
+	bool DunGen::CVoxelSpace::HasMarks(unsigned int x_, unsigned int y_, unsigned int z_) const
+	{
+		return NULL != GetBrick(x_,y_,z_).Marks;
+	}
+
+} // END NAMESPACE DunGen
+
+#endif
@@ -54,7 +54,7 @@ namespace DunGen
 		// L-system creation functions:
 
 		/// Create a derivation of the L-system.
-		/// \param desiredIteration The desired iteration. The derivation will eventually be lower if the length of the generated string would exceed 1,000,000 instructions.
+		/// \param desiredIteration The desired iteration. The derivation will eventually be lower if the length of the generated string would exceed the maximum length (see DunGen::LSystemSetMaxLength).
 		/// \return The generated iteration.
 		unsigned int CreateLSystemDerivation(unsigned int desiredIteration);
 
@@ -66,10 +66,26 @@ namespace DunGen
 		/// Erodes the voxel cave 1 voxel deep. Can be applied muliple times.
 		/// \param erosionLikelihood The likelihood, with which the voxels are removed.
 		void ErodeVoxelCave(double erosionLikelihood);
+
+		/// Erodes the voxel cave several times, 1 voxel deep per iteration.
+		/// The border of the cave is only searched once, so further iterations are cheap.
+		/// The result is identical to calling ErodeVoxelCave(erosionLikelihood) iterations times.
+		/// \param erosionLikelihood The likelihood, with which the voxels are removed.
+		/// \param iterations The number of erosions.
+		void ErodeVoxelCave(double erosionLikelihood, unsigned int iterations);
 		
 		/// Removes all hovering fragments.
+		/// The result depends on the filter mode (see DunGen::VoxelCaveSetFilterMode).
+		/// Note: The mode EFilterMode::COMPONENTS keeps stone, that is connected to the border of the voxel space, but not to the outer hull of the cave
+		/// (e.g. stone between tunnel systems not connected to each other), so the result differs from the default mode EFilterMode::OUTER_HULL.
 		void RemoveHoveringVoxelFragments();
 
+		/// Removes the small hovering fragments, larger ones are kept.
+		/// This needs the filter mode EFilterMode::COMPONENTS: the stone is split up into connected components, the component connected to the border of the voxel space is never removed.
+		/// In the default filter mode EFilterMode::OUTER_HULL, all fragments are removed as in older versions.
+		/// \param maxFragmentSize The maximum number of voxels of a removed fragment.
+		void RemoveHoveringVoxelFragments(unsigned int maxFragmentSize);
+
 		// Mesh cave creation functions:
 
 		/// Creates the mesh cave from the currently generated voxel cave.
@@ -162,6 +178,13 @@ namespace DunGen
 		/// \param m The parameter m.
 		void RandomGeneratorSetParameters(unsigned int seed, unsigned int a, unsigned int c, unsigned int m);
 
+		/// Enables the legacy mode of the random generator.
+		/// By default erosion, warping and detail object placement use a stateless hash generator (value = f(seed, x, y, z, stream)).
+		/// The legacy mode draws sequential numbers from the linear congruential generator instead, so the random number sequence of older versions is reproduced.
+		/// It only affects the random numbers: the voxel caves still differ from versions before 2.0, because their tunnels are rasterized differently (as capsules).
+		/// \param legacyMode Use the linear congruential generator.
+		void RandomGeneratorSetLegacyMode(bool legacyMode);
+
 		// L-system parameter functions:
 
 		/// Adds a substitution rule for the L-system.
@@ -181,6 +204,32 @@ namespace DunGen
 		/// \param value The value to be set.
 		void LSystemSetParameter(ELSystemParameter::Enum parameter, double value);
 
+		/// Sets the maximum length of the L-system derivations in instructions (default 1,000,000).
+		///
+		/// The derivation is expanded symbol by symbol while drawing the voxel cave and never stored as a whole,
+		/// so the derivation itself needs (almost) no memory; the lines drawn from it are kept until they are rasterized.
+		/// The default is kept from older versions, to lift the limit set 0.
+		/// \param maxLength The maximum length, 0 means no limit.
+		void LSystemSetMaxLength(unsigned int maxLength);
+
+		/// Predicts the length of a derivation of the L-system in instructions without creating it.
+		///
+		/// The length is computed from the symbol counts of the substitution rules and thus costs (almost) no time,
+		/// even for derivations far too large to be drawn.
+		/// \param derivation The iteration of the derivation.
+		/// \return The predicted length.
+		double LSystemPredictLength(unsigned int derivation) const;
+
+		/// Predicts the bounding box of the turtle graphic of a derivation of the L-system without creating it.
+		///
+		/// The box is composed from the movement of the turtle per symbol and iteration and contains the turtle graphic.
+		/// If the rules use '$' or unbalanced brackets, only a coarse box (derived from the number of lines) is computed.
+		/// \param derivation The iteration of the derivation.
+		/// \param min Returns the minimum corner of the box.
+		/// \param max Returns the maximum corner of the box.
+		/// \return True, if the box is tight, false if it is only coarse.
+		bool LSystemPredictBoundingBox(unsigned int derivation, irr::core::vector3d<double>& min, irr::core::vector3d<double>& max) const;
+
 		// Voxel cave parameter functions:
 
 		/// Sets the parameters of the voxel cave.
@@ -188,9 +237,66 @@ namespace DunGen
 		/// \param mindrawradius The minimum drawing radius, which will be not deceeded.
 		void VoxelCaveSetParameters(unsigned int border, unsigned int mindrawradius);
 
+		/// Sets the dimensions of the voxel space. The content of the voxel space is cleared, if the dimensions change.
+		///
+		/// Smaller voxel spaces are faster to create, erode, filter and convert. The cave is scaled to fit the voxel space.
+		/// \param dimX The X dimension. Will be clamped to [SVoxelSpace::MinDim,SVoxelSpace::MaxDim].
+		/// \param dimY The Y dimension. Will be clamped to [SVoxelSpace::MinDim,SVoxelSpace::MaxDim].
+		/// \param dimZ The Z dimension. Will be clamped to [SVoxelSpace::MinDim,SVoxelSpace::MaxDim].
+		void VoxelCaveSetDimensions(unsigned int dimX, unsigned int dimY, unsigned int dimZ);
+
+		/// Enables or disables the distance field of the voxel cave (disabled by default).
+		///
+		/// If enabled, the voxel cave additionally stores the quantized distances to the cave walls near the surface while it is created.
+		/// The mesh cave then places its vertices onto the smooth surface given by these distances instead of warping them,
+		/// so smooth caves can be created with a smaller voxel space. The warp parameters are ignored in this case.
+		/// \param enabled True to compute the distance field.
+		void VoxelCaveSetDistanceField(bool enabled);
+
+		/// Sets how hovering fragments are removed (EFilterMode::OUTER_HULL by default).
+		/// This is independent of the legacy mode of the random generator.
+		/// \param value The filter mode.
+		void VoxelCaveSetFilterMode(EFilterMode::Enum value);
+
+		/// Gets the dimensions of the voxel space.
+		/// \returns The dimensions of the voxel space.
+		irr::core::vector3d<unsigned int> VoxelCaveGetDimensions() const;
+
 		/// Estimates the mesh complexity for the mesh cave which results from the current voxel cave.
+		/// The result is kept per brick of the voxel space, only the bricks changed since the last call are counted again,
+		/// so calling it repeatedly (e.g. while tuning parameters) is cheap.
+		/// It is not const and not thread-safe, because the kept counts are updated.
 		/// \returns The estimated number of triangles needed.
-		unsigned int VoxelCaveEstimateMeshComplexity() const;
+		unsigned int VoxelCaveEstimateMeshComplexity();
+
+		/// Returns the number of bytes of the voxel space, that have been touched to clear it when the voxel cave was created the last time.
+		/// Only the region written by the previous generation is cleared, so this shows the clearing costs per generation.
+		/// \returns The number of bytes touched for clearing.
+		unsigned int VoxelCaveGetClearedBytes() const;
+
+		/// Returns the maximum depth of the turtle stack (nested '[') reached when the voxel cave was drawn the last time.
+		/// The stack of turtle states is kept between the generations, so this shows the memory needed for branching.
+		/// \returns The maximum number of saved turtle states.
+		unsigned int VoxelCaveGetTurtlePeakDepth() const;
+
+		/// Returns the maximum number of voxel runs waiting in the flood fill of the outer hull, when hovering fragments were removed the last time (filter mode EFilterMode::OUTER_HULL).
+		/// This shows the memory needed for filtering (12 bytes per run).
+		/// \returns The maximum number of waiting runs.
+		unsigned int VoxelCaveGetFilterPeakFrontier() const;
+
+		/// Returns the number of hovering fragments found when hovering fragments were removed the last time (0 in filter mode EFilterMode::OUTER_HULL).
+		/// \returns The number of hovering fragments (removed and kept).
+		unsigned int VoxelCaveGetFragmentCount() const;
+
+		/// Returns the size of a hovering fragment found when hovering fragments were removed the last time.
+		/// \param index The index of the fragment, the fragments are sorted by decreasing size.
+		/// \returns The number of voxels of the fragment.
+		unsigned int VoxelCaveGetFragmentSize(unsigned int index) const;
+
+		/// Counts the parts of the voxel cave, that are not connected to each other (6-connected components of the free voxels).
+		/// Caves that split up into several parts can be rejected with this.
+		/// \returns The number of cave parts.
+		unsigned int VoxelCaveGetCavePartCount() const;
 
 		// Mesh cave parameter functions:
 
@@ -266,15 +372,23 @@ namespace DunGen
 		// other
 		//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-		/// Provides direct access to voxel space.
+		/// Sets a voxel of the voxel space.
 		///
-		/// Use with: unsigned char (&voxelspace)[DunGen::SVoxelSpace::DimX][DunGen::SVoxelSpace::DimY][DunGen::SVoxelSpace::DimZ] = dunGen->GetVoxelSpace(); .
-		/// Then you can set voxels with: voxelspace[x][y][z] = value; .
 		/// Only set voxels to 0 (stone) or 1 (free space), preserve a three voxel border of 0-voxels.
 		/// All 1-voxel have to be 6-connected.
-		/// Be careful with this (could crash if you do not preserve the border).
-		/// \returns A reference to the three-dimensional array of the voxel space.
-		unsigned char (&GetVoxelSpace())[SVoxelSpace::DimX][SVoxelSpace::DimY][SVoxelSpace::DimZ];
+		/// Be careful with this (could crash if you do not preserve the border or access voxels outside the voxel space).
+		/// \param x X coordinate of the voxel.
+		/// \param y Y coordinate of the voxel.
+		/// \param z Z coordinate of the voxel.
+		/// \param value The value to be set.
+		void VoxelCaveSetVoxel(unsigned int x, unsigned int y, unsigned int z, unsigned char value);
+
+		/// Gets a voxel of the voxel space.
+		/// \param x X coordinate of the voxel.
+		/// \param y Y coordinate of the voxel.
+		/// \param z Z coordinate of the voxel.
+		/// \returns The value of the voxel: 0 (stone), 1 (free space), 3 (docking voxel).
+		unsigned char VoxelCaveGetVoxel(unsigned int x, unsigned int y, unsigned int z) const;
 
 	private:
 		/// Private copy constructor, because it shall not be used.
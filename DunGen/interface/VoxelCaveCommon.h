@@ -10,12 +10,24 @@ namespace DunGen
 	/// Parameters for the voxelspace.
 	struct SVoxelSpace
 	{
-		/// X dimension of the Voxel space.
-		static const unsigned int DimX = 512;
-		/// Y dimension of the Voxel space.
-		static const unsigned int DimY = 512;
-		/// Z dimension of the Voxel space.
-		static const unsigned int DimZ = 512;
+		/// Default X dimension of the Voxel space.
+		static const unsigned int DefaultDimX = 512;
+		/// Default Y dimension of the Voxel space.
+		static const unsigned int DefaultDimY = 512;
+		/// Default Z dimension of the Voxel space.
+		static const unsigned int DefaultDimZ = 512;
+
+		/// Deprecated: X dimension of the Voxel space before it could be chosen at runtime, use DefaultDimX or CDunGen::VoxelCaveGetDimensions().
+		static const unsigned int DimX = DefaultDimX;
+		/// Deprecated: Y dimension of the Voxel space before it could be chosen at runtime, use DefaultDimY or CDunGen::VoxelCaveGetDimensions().
+		static const unsigned int DimY = DefaultDimY;
+		/// Deprecated: Z dimension of the Voxel space before it could be chosen at runtime, use DefaultDimZ or CDunGen::VoxelCaveGetDimensions().
+		static const unsigned int DimZ = DefaultDimZ;
+
+		/// Minimal dimension of the Voxel space (per axis).
+		static const unsigned int MinDim = 32;
+		/// Maximal dimension of the Voxel space (per axis).
+		static const unsigned int MaxDim = 1024;
 
 		/// Minimal distance of 1-voxels to the border of the voxel space.
 		///
@@ -24,6 +36,16 @@ namespace DunGen
 		/// This results in a huge speedup, because fewer branching is required.
 		static const unsigned int MinBorder = 3;
 	};	
+
+	/// Methods for removing hovering fragments.
+	struct EFilterMode
+	{
+		enum Enum
+		{
+			COMPONENTS	= 0,	///< The stone is split up into connected components, all components not connected to the border of the voxel space up to a maximum size are removed.
+			OUTER_HULL	= 1		///< The outer hull of the cave is flood filled and all stone behind it is removed (default, as in older versions, the maximum fragment size is ignored).
+		};
+	};
 }
 
 #endif
\ No newline at end of file
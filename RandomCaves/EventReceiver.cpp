@@ -204,15 +204,38 @@ void CEventReceiver::GenerateCave()
 {
 	std::cout << "Generating Cave ... " << std::endl;
 	srand (static_cast<unsigned int>(time(NULL)));
+
+	// roll until the L-system is usable (checked by prediction, without creating the derivation)
+	for (unsigned int attempt=1; ; ++attempt)
+	{
+		if (!RollParameters())
+		{
+			std::cout << "failed." << std::endl;
+			return;
+		}
+
+		if (IsUsable())
+			break;
+
+		if (MaxAttempts == attempt)
+		{
+			std::cout << "no usable L-system found, taking the last one." << std::endl;
+			break;
+		}
+	}
+
+	Apply();
+	std::cout << "done." << std::endl;
+}
+
+bool CEventReceiver::RollParameters()
+{
 	Rules.clear();
 	DungeonGenerator->LSystemDeleteRules();
 
 	irr::io::IReadFile* file = IrrDevice->getFileSystem()->createAndOpenFile("RandomCavesConfig.xml");
 	if (!file)
-	{
-		std::cout << "failed." << std::endl;
-		return;
-	}
+		return false;
 	irr::io::IXMLReader* xmlReader = IrrDevice->getFileSystem()->createXMLReader(file);
 
 	std::string replacementCandidates;
@@ -300,9 +323,31 @@ void CEventReceiver::GenerateCave()
 	// close file
 	xmlReader->drop();
 	file->drop();
+	return true;
+}
 
-	Apply();
-	std::cout << "done." << std::endl;
+bool CEventReceiver::IsUsable()
+{
+	// too long: the derivation would be cut down by DunGen
+	const double length = DungeonGenerator->LSystemPredictLength(Derivation);
+	if (length > MaxLength)
+	{
+		std::cout << "rejected: predicted length " << length << std::endl;
+		return false;
+	}
+
+	// degenerated: the turtle graphic does not extend in at least two directions
+	irr::core::vector3d<double> min, max;
+	DungeonGenerator->LSystemPredictBoundingBox(Derivation, min, max);
+	const irr::core::vector3d<double> size = max - min;
+	const unsigned int extendedDirections = (size.X >= 1.0 ? 1 : 0) + (size.Y >= 1.0 ? 1 : 0) + (size.Z >= 1.0 ? 1 : 0);
+	if (extendedDirections < 2)
+	{
+		std::cout << "rejected: predicted size " << size.X << " x " << size.Y << " x " << size.Z << std::endl;
+		return false;
+	}
+
+	return true;
 }
 
 void CEventReceiver::SaveCave()
@@ -46,6 +46,12 @@ private:
 	/// Generate a cave.
 	void GenerateCave();
 
+	/// Rolls the L-system according to the config file.
+	bool RollParameters();
+
+	/// Checks the predicted length and size of the rolled L-system.
+	bool IsUsable();
+
 	/// Save the cave as XML.
 	void SaveCave();
 
@@ -56,6 +62,13 @@ private:
 		std::string Replacement;
 	};
 
+private:
+	/// maximum number of rolls for a usable L-system
+	static const unsigned int MaxAttempts = 20;
+
+	/// maximum predicted length of a usable L-system
+	static const unsigned int MaxLength = 1000000;
+
 private:
 	DunGen::CDunGen* DungeonGenerator;
 	irr::IrrlichtDevice* IrrDevice;
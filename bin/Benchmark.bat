@@ -0,0 +1,6 @@
+@echo Benchmark.exe runs dimension , Benchmark.exe check
+Benchmark.exe check
+Benchmark.exe 3 512
+BenchmarkMorton.exe check
+BenchmarkMorton.exe 3 512
+pause
\ No newline at end of file